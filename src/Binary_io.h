@@ -0,0 +1,86 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#ifndef BINARY_IO_H
+#define BINARY_IO_H
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace KMC_Lattice_example {
+
+	// These utility functions write and read trivially copyable values, vectors of values, strings, and
+	// random number generator states in native binary format for the checkpoint files.
+	// The read functions return false if the stream does not contain enough data.
+
+	template<typename T>
+	void writeBinary(std::ostream& stream, const T& value) {
+		stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	bool readBinary(std::istream& stream, T& value) {
+		stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+		return stream.good();
+	}
+
+	template<typename T>
+	void writeBinaryVector(std::ostream& stream, const std::vector<T>& values) {
+		writeBinary(stream, (long int)values.size());
+		if (!values.empty()) {
+			stream.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+		}
+	}
+
+	template<typename T>
+	bool readBinaryVector(std::istream& stream, std::vector<T>& values) {
+		long int size = 0;
+		if (!readBinary(stream, size) || size < 0) {
+			return false;
+		}
+		values.resize(size);
+		if (size > 0) {
+			stream.read(reinterpret_cast<char*>(values.data()), size * sizeof(T));
+		}
+		return stream.good();
+	}
+
+	inline void writeBinaryString(std::ostream& stream, const std::string& str) {
+		writeBinaryVector(stream, std::vector<char>(str.begin(), str.end()));
+	}
+
+	inline bool readBinaryString(std::istream& stream, std::string& str) {
+		std::vector<char> chars;
+		if (!readBinaryVector(stream, chars)) {
+			return false;
+		}
+		str.assign(chars.begin(), chars.end());
+		return true;
+	}
+
+	// The state of the standard library random number engines is only available in text format
+	template<typename Engine>
+	void writeGeneratorState(std::ostream& stream, const Engine& generator) {
+		std::stringstream ss;
+		ss << generator;
+		writeBinaryString(stream, ss.str());
+	}
+
+	template<typename Engine>
+	bool readGeneratorState(std::istream& stream, Engine& generator) {
+		std::string state;
+		if (!readBinaryString(stream, state)) {
+			return false;
+		}
+		std::stringstream ss(state);
+		ss >> generator;
+		return !ss.fail();
+	}
+
+}
+
+#endif // BINARY_IO_H
@@ -0,0 +1,222 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#include "Correlated_dos.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+namespace KMC_Lattice_example {
+
+	namespace {
+
+		const double pi = 3.14159265358979323846;
+
+		// Performs an in-place forward discrete Fourier transform of a sequence whose length is a power of two
+		// using the iterative radix-2 Cooley-Tukey algorithm
+		void fftRadix2(vector<complex<double>>& data) {
+			const int n = (int)data.size();
+			// Reorder the data into bit-reversed order
+			for (int i = 1, j = 0; i < n; i++) {
+				int bit = n >> 1;
+				for (; j & bit; bit >>= 1) {
+					j ^= bit;
+				}
+				j ^= bit;
+				if (i < j) {
+					swap(data[i], data[j]);
+				}
+			}
+			for (int len = 2; len <= n; len <<= 1) {
+				const complex<double> w_len = polar(1.0, -2.0 * pi / len);
+				for (int i = 0; i < n; i += len) {
+					complex<double> w(1.0, 0.0);
+					for (int j = 0; j < len / 2; j++) {
+						complex<double> u = data[i + j];
+						complex<double> v = data[i + j + len / 2] * w;
+						data[i + j] = u + v;
+						data[i + j + len / 2] = u - v;
+						w *= w_len;
+					}
+				}
+			}
+		}
+
+		// Stores the precomputed data needed to perform forward Fourier transforms of one sequence length
+		// Lengths that are not powers of two are transformed with Bluestein's algorithm, which expresses the transform
+		// as a convolution that is calculated with radix-2 transforms of a padded length.
+		class Fft_plan {
+		public:
+			explicit Fft_plan(const int n_in) {
+				n = n_in;
+				is_pow2 = (n & (n - 1)) == 0;
+				if (is_pow2) {
+					return;
+				}
+				m = 1;
+				while (m < 2 * n - 1) {
+					m <<= 1;
+				}
+				chirp.resize(n);
+				for (int k = 0; k < n; k++) {
+					// Reduce k^2 modulo 2n to keep the phase accurate for long sequences
+					long int k2 = ((long int)k * k) % (2L * n);
+					chirp[k] = polar(1.0, -pi * k2 / n);
+				}
+				chirp_filter.assign(m, complex<double>(0.0, 0.0));
+				chirp_filter[0] = conj(chirp[0]);
+				for (int k = 1; k < n; k++) {
+					chirp_filter[k] = conj(chirp[k]);
+					chirp_filter[m - k] = conj(chirp[k]);
+				}
+				fftRadix2(chirp_filter);
+			}
+
+			// Performs an in-place forward transform of the sequence, using the work vector as scratch space
+			void transform(vector<complex<double>>& data, vector<complex<double>>& work) const {
+				if (is_pow2) {
+					fftRadix2(data);
+					return;
+				}
+				work.assign(m, complex<double>(0.0, 0.0));
+				for (int k = 0; k < n; k++) {
+					work[k] = data[k] * chirp[k];
+				}
+				fftRadix2(work);
+				// Multiply by the transformed chirp filter and calculate the inverse transform using the conjugate
+				for (int k = 0; k < m; k++) {
+					work[k] = conj(work[k] * chirp_filter[k]);
+				}
+				fftRadix2(work);
+				for (int k = 0; k < n; k++) {
+					data[k] = conj(work[k]) * chirp[k] / (double)m;
+				}
+			}
+
+		private:
+			int n;
+			int m = 0;
+			bool is_pow2;
+			vector<complex<double>> chirp;
+			vector<complex<double>> chirp_filter;
+		};
+
+		// Transforms all lines of the 3D array along one direction, where the lines have the specified length and
+		// element stride, and the line starts are given by the specified function of the line number
+		// The inverse transform is calculated using the conjugate of the forward transform and is not normalized.
+		template<typename Start_function>
+		void transformLines(vector<complex<double>>& data, const int line_length, const long int stride, const long int N_lines, Start_function getLineStart, const bool inverse, const int N_threads) {
+			const Fft_plan plan(line_length);
+			auto transformRange = [&](const long int line_begin, const long int line_end) {
+				vector<complex<double>> line(line_length);
+				vector<complex<double>> work;
+				for (long int l = line_begin; l < line_end; l++) {
+					const long int start = getLineStart(l);
+					for (int i = 0; i < line_length; i++) {
+						line[i] = inverse ? conj(data[start + i * stride]) : data[start + i * stride];
+					}
+					plan.transform(line, work);
+					for (int i = 0; i < line_length; i++) {
+						data[start + i * stride] = inverse ? conj(line[i]) : line[i];
+					}
+				}
+			};
+			if (N_threads <= 1) {
+				transformRange(0, N_lines);
+				return;
+			}
+			vector<thread> threads;
+			for (int t = 0; t < N_threads; t++) {
+				threads.emplace_back(transformRange, N_lines * t / N_threads, N_lines * (t + 1) / N_threads);
+			}
+			for (auto& item : threads) {
+				item.join();
+			}
+		}
+
+		// Calculates the 3D transform of the array by transforming along z, y, and then x
+		void transform3D(vector<complex<double>>& data, const int length, const int width, const int height, const bool inverse, const int N_threads) {
+			const long int plane = (long int)width * height;
+			transformLines(data, height, 1, (long int)length * width, [height](const long int l) { return l * height; }, inverse, N_threads);
+			transformLines(data, width, height, (long int)length * height, [plane, height](const long int l) { return (l / height) * plane + l % height; }, inverse, N_threads);
+			transformLines(data, length, plane, plane, [](const long int l) { return l; }, inverse, N_threads);
+		}
+
+		// Gets the wavenumber (nm^-1) of the specified frequency index of a transform with the specified length
+		double calculateWavenumber(const int index, const int length, const double unit_size) {
+			const int index_signed = (index <= length / 2) ? index : index - length;
+			return 2.0 * pi * index_signed / (length * unit_size);
+		}
+
+	}
+
+	void createCorrelatedGaussianDOSVector(vector<double>& data, const int length, const int width, const int height, const double unit_size, const double stdev, const double correlation_length, const Random_stream& stream, const int N_threads) {
+		if (length <= 0 || width <= 0 || height <= 0 || !(unit_size > 0) || stdev < 0 || correlation_length < 0) {
+			throw invalid_argument("Error! The correlated Gaussian DOS requires positive lattice dimensions and unit size and a non-negative standard deviation and correlation length.");
+		}
+		const long int N_sites = (long int)length * width * height;
+		// Create uncorrelated Gaussian white noise with the Box-Muller transform of the stream outputs at twice the site index and
+		// twice the site index plus one, so that the noise of each site does not depend on how the sites are divided between threads
+		vector<complex<double>> field(N_sites);
+		auto createNoise = [&](const long int site_begin, const long int site_end) {
+			Random_stream stream_range = stream;
+			stream_range.setPosition(2 * (uint64_t)site_begin);
+			double uniforms[2];
+			for (long int i = site_begin; i < site_end; i++) {
+				stream_range.generateUniforms(uniforms, 2);
+				field[i] = complex<double>(sqrt(-2.0 * log(1.0 - uniforms[0])) * cos(2.0 * pi * uniforms[1]), 0.0);
+			}
+		};
+		if (N_threads <= 1) {
+			createNoise(0, N_sites);
+		}
+		else {
+			vector<thread> threads;
+			for (int t = 0; t < N_threads; t++) {
+				threads.emplace_back(createNoise, N_sites * t / N_threads, N_sites * (t + 1) / N_threads);
+			}
+			for (auto& item : threads) {
+				item.join();
+			}
+		}
+		// Convolve the noise with a Gaussian kernel exp(-r^2/(2*a^2)) with a = correlation_length/sqrt(2), whose Fourier
+		// transform is exp(-k^2*correlation_length^2/4), so that the correlation function is exp(-r^2/(2*correlation_length^2))
+		transform3D(field, length, width, height, false, N_threads);
+		const double factor = -0.25 * correlation_length * correlation_length;
+		for (int x = 0; x < length; x++) {
+			const double kx = calculateWavenumber(x, length, unit_size);
+			for (int y = 0; y < width; y++) {
+				const double ky = calculateWavenumber(y, width, unit_size);
+				for (int z = 0; z < height; z++) {
+					const double kz = calculateWavenumber(z, height, unit_size);
+					field[((long int)x * width + y) * height + z] *= exp(factor * (kx * kx + ky * ky + kz * kz));
+				}
+			}
+		}
+		transform3D(field, length, width, height, true, N_threads);
+		// Shift and scale the energies to the specified mean and standard deviation
+		data.resize(N_sites);
+		double sum = 0.0;
+		for (long int i = 0; i < N_sites; i++) {
+			data[i] = field[i].real();
+			sum += data[i];
+		}
+		const double mean = sum / N_sites;
+		double sum_sq = 0.0;
+		for (auto& item : data) {
+			item -= mean;
+			sum_sq += item * item;
+		}
+		const double scale = (sum_sq > 0) ? stdev / sqrt(sum_sq / N_sites) : 0.0;
+		for (auto& item : data) {
+			item *= scale;
+		}
+	}
+
+}
@@ -0,0 +1,26 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#ifndef CORRELATED_DOS_H
+#define CORRELATED_DOS_H
+
+#include "Random_stream.h"
+#include <vector>
+
+namespace KMC_Lattice_example {
+
+	// Creates spatially correlated Gaussian site energies for a lattice with the specified dimensions and unit size (nm).
+	// The energies are ordered by the lattice site index, where z varies fastest and x varies slowest.
+	// Uncorrelated Gaussian white noise is convolved with a Gaussian kernel using fast Fourier transforms, so that the
+	// energy correlation function decays as exp(-r^2/(2*correlation_length^2)), and the energies are then shifted and
+	// scaled to have zero mean and the specified standard deviation (eV).  The convolution is periodic in all directions.
+	// The noise of each site is created from the outputs of the random number stream at positions given by the site index,
+	// which does not change the position of the stream.  The noise creation and the Fourier transforms of the lattice lines
+	// along each direction are divided between N_threads threads, and the result does not depend on the number of threads.
+	void createCorrelatedGaussianDOSVector(std::vector<double>& data, const int length, const int width, const int height, const double unit_size, const double stdev, const double correlation_length, const Random_stream& stream, const int N_threads);
+
+}
+
+#endif // CORRELATED_DOS_H
@@ -0,0 +1,185 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#include "Energy_landscape.h"
+#include "Binary_io.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace KMC_Lattice_example {
+
+	// Identifies the landscape file format
+	static const char landscape_magic[8] = { 'K', 'M', 'C', 'X', 'L', 'A', 'N', 'D' };
+	static const int landscape_version = 1;
+	static const size_t landscape_header_size = 32;
+
+	Energy_landscape::~Energy_landscape() {
+		unmapFile();
+	}
+
+	bool Energy_landscape::openFile(const string& filename) {
+		close();
+		if (!mapFile(filename)) {
+			return false;
+		}
+		energies_ptr = reinterpret_cast<const float*>(static_cast<const char*>(map_ptr) + landscape_header_size);
+		return true;
+	}
+
+	bool Energy_landscape::openShared(const string& filename, MPI_Comm comm) {
+		close();
+		int procid = 0;
+		MPI_Comm_rank(comm, &procid);
+		// Processor 0 checks the file and then shares the lattice dimensions with the other processors
+		int success = (procid == 0) ? (int)mapFile(filename) : 0;
+		MPI_Bcast(&success, 1, MPI_INT, 0, comm);
+		if (!success) {
+			return false;
+		}
+		int dims[3] = { length, width, height };
+		MPI_Bcast(dims, 3, MPI_INT, 0, comm);
+		MPI_Bcast(&unit_size, 1, MPI_DOUBLE, 0, comm);
+		length = dims[0];
+		width = dims[1];
+		height = dims[2];
+		// Only processor 0 allocates memory in the shared window, and all other processors get a pointer to it
+		float* window_ptr = nullptr;
+		MPI_Aint window_size = (procid == 0) ? (MPI_Aint)(getNumSites() * sizeof(float)) : 0;
+		MPI_Win_allocate_shared(window_size, sizeof(float), MPI_INFO_NULL, comm, &window_ptr, &window);
+		if (procid == 0) {
+			memcpy(window_ptr, static_cast<const char*>(map_ptr) + landscape_header_size, getNumSites() * sizeof(float));
+			unmapFile();
+		}
+		else {
+			MPI_Aint size = 0;
+			int disp_unit = 0;
+			MPI_Win_shared_query(window, 0, &size, &disp_unit, &window_ptr);
+		}
+		is_shared = true;
+		// Wait until processor 0 has copied the energies into the window
+		MPI_Win_fence(0, window);
+		energies_ptr = window_ptr;
+		return true;
+	}
+
+	void Energy_landscape::close() {
+		if (is_shared) {
+			MPI_Win_free(&window);
+			is_shared = false;
+		}
+		unmapFile();
+		energies_ptr = nullptr;
+	}
+
+	int Energy_landscape::getLength() const {
+		return length;
+	}
+
+	int Energy_landscape::getWidth() const {
+		return width;
+	}
+
+	int Energy_landscape::getHeight() const {
+		return height;
+	}
+
+	long int Energy_landscape::getNumSites() const {
+		return (long int)length * width * height;
+	}
+
+	double Energy_landscape::getUnitSize() const {
+		return unit_size;
+	}
+
+	bool Energy_landscape::writeFile(const string& filename, const int length_in, const int width_in, const int height_in, const double unit_size_in, const vector<float>& energies) {
+		if ((long int)energies.size() != (long int)length_in * width_in * height_in) {
+			cout << "Error! The number of site energies does not match the lattice dimensions of landscape file " << filename << "." << endl;
+			return false;
+		}
+		ofstream file(filename, ofstream::binary);
+		if (!file) {
+			cout << "Error! Landscape file " << filename << " could not be created." << endl;
+			return false;
+		}
+		file.write(landscape_magic, sizeof(landscape_magic));
+		writeBinary(file, landscape_version);
+		writeBinary(file, length_in);
+		writeBinary(file, width_in);
+		writeBinary(file, height_in);
+		writeBinary(file, unit_size_in);
+		file.write(reinterpret_cast<const char*>(energies.data()), energies.size() * sizeof(float));
+		file.close();
+		if (!file) {
+			cout << "Error! Landscape file " << filename << " could not be written." << endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool Energy_landscape::mapFile(const string& filename) {
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0) {
+			cout << "Error! Landscape file " << filename << " could not be opened." << endl;
+			return false;
+		}
+		struct stat file_stat;
+		if (fstat(fd, &file_stat) != 0 || (size_t)file_stat.st_size < landscape_header_size) {
+			cout << "Error! " << filename << " is not a valid landscape file." << endl;
+			::close(fd);
+			return false;
+		}
+		map_size = (size_t)file_stat.st_size;
+		map_ptr = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		// The mapping remains valid after the file is closed
+		::close(fd);
+		if (map_ptr == MAP_FAILED) {
+			cout << "Error! Landscape file " << filename << " could not be memory-mapped." << endl;
+			map_ptr = nullptr;
+			map_size = 0;
+			return false;
+		}
+		// Check the header
+		const char* data = static_cast<const char*>(map_ptr);
+		int version = 0;
+		memcpy(&version, data + 8, sizeof(int));
+		memcpy(&length, data + 12, sizeof(int));
+		memcpy(&width, data + 16, sizeof(int));
+		memcpy(&height, data + 20, sizeof(int));
+		memcpy(&unit_size, data + 24, sizeof(double));
+		if (!equal(data, data + sizeof(landscape_magic), landscape_magic)) {
+			cout << "Error! " << filename << " is not a valid landscape file." << endl;
+			unmapFile();
+			return false;
+		}
+		if (version != landscape_version) {
+			cout << "Error! Landscape file version " << version << " is not supported." << endl;
+			unmapFile();
+			return false;
+		}
+		if (length <= 0 || width <= 0 || height <= 0 || !(unit_size > 0) || map_size != landscape_header_size + getNumSites() * sizeof(float)) {
+			cout << "Error! The size of landscape file " << filename << " does not match its lattice dimensions." << endl;
+			unmapFile();
+			return false;
+		}
+		return true;
+	}
+
+	void Energy_landscape::unmapFile() {
+		if (map_ptr != nullptr) {
+			munmap(map_ptr, map_size);
+			map_ptr = nullptr;
+			map_size = 0;
+		}
+	}
+
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#ifndef ENERGY_LANDSCAPE_H
+#define ENERGY_LANDSCAPE_H
+
+#include <mpi.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace KMC_Lattice_example {
+
+	// This class provides read-only access to a site energy landscape stored in a binary landscape file.
+	// The file starts with a 32 byte header containing the 8 character identifier "KMCXLAND", the 32-bit
+	// integer format version, the 32-bit integer Length, Width, and Height of the lattice, and the 64-bit
+	// floating point Unit_size in nm.  The header is followed by the 32-bit floating point energy of each
+	// site in eV in the order of the lattice site index.  All values use the native byte order.
+	// The file can either be memory-mapped by each processor, so that pages are only loaded when they are
+	// used, or loaded once per node into an MPI shared memory window that is used by all processors on the node.
+	class Energy_landscape {
+	public:
+		// Constructs an empty landscape that has not been opened
+		Energy_landscape() {}
+
+		// The memory mapping is released by the destructor, but a shared memory window must be closed explicitly
+		~Energy_landscape();
+
+		Energy_landscape(const Energy_landscape&) = delete;
+		Energy_landscape& operator=(const Energy_landscape&) = delete;
+
+		// Opens the landscape file by memory-mapping it and returns false if the file cannot be opened or is not valid
+		bool openFile(const std::string& filename);
+
+		// Loads the landscape file into an MPI shared memory window, where only processor 0 in the communicator reads
+		// the file.  This is a collective operation that must be called by all processors in the communicator, which
+		// must all be able to share memory, such as a communicator created by MPI_Comm_split_type with
+		// MPI_COMM_TYPE_SHARED.  Returns false on all processors if the file cannot be opened or is not valid.
+		bool openShared(const std::string& filename, MPI_Comm comm);
+
+		// Releases the memory mapping or the shared memory window.  When the landscape was opened with openShared,
+		// this is a collective operation that must be called by all processors in the communicator before MPI_Finalize.
+		void close();
+
+		// Gets the energy of the site with the specified lattice site index
+		double getEnergy(const long int site_index) const { return energies_ptr[site_index]; }
+
+		// Gets the lattice dimensions of the landscape
+		int getLength() const;
+		int getWidth() const;
+		int getHeight() const;
+
+		// Gets the total number of sites in the landscape
+		long int getNumSites() const;
+
+		// Gets the lattice unit size of the landscape in nm
+		double getUnitSize() const;
+
+		// Writes a landscape file with the specified lattice dimensions, unit size, and site energies and returns false
+		// if the file cannot be written
+		static bool writeFile(const std::string& filename, const int length, const int width, const int height, const double unit_size, const std::vector<float>& energies);
+
+	private:
+		int length = 0;
+		int width = 0;
+		int height = 0;
+		double unit_size = 0.0;
+		const float* energies_ptr = nullptr;
+		// Memory mapping of the landscape file
+		void* map_ptr = nullptr;
+		size_t map_size = 0;
+		// Shared memory window holding the energies
+		MPI_Win window;
+		bool is_shared = false;
+
+		// Maps the file into memory, checks the header, and sets the lattice dimensions
+		bool mapFile(const std::string& filename);
+
+		// Releases the memory mapping of the file
+		void unmapFile();
+	};
+
+}
+
+#endif // ENERGY_LANDSCAPE_H
@@ -0,0 +1,117 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#include "Event_heap.h"
+#include <utility>
+
+using namespace std;
+
+namespace KMC_Lattice_example {
+
+	void Event_heap::clear() {
+		times.clear();
+		handles.clear();
+		positions.clear();
+	}
+
+	bool Event_heap::empty() const {
+		return handles.empty();
+	}
+
+	int Event_heap::getNextHandle() const {
+		return handles[0];
+	}
+
+	double Event_heap::getNextTime() const {
+		return times[0];
+	}
+
+	int Event_heap::getN_events() const {
+		return (int)handles.size();
+	}
+
+	bool Event_heap::contains(const int handle) const {
+		return handle < (int)positions.size() && positions[handle] >= 0;
+	}
+
+	// The removed entry is replaced by the last entry, which is then moved up or down to its correct position
+	void Event_heap::remove(const int handle) {
+		if (!contains(handle)) {
+			return;
+		}
+		const int position = positions[handle];
+		const int position_last = (int)handles.size() - 1;
+		if (position != position_last) {
+			swapEntries(position, position_last);
+		}
+		times.pop_back();
+		handles.pop_back();
+		positions[handle] = -1;
+		if (position < (int)handles.size()) {
+			const int handle_moved = handles[position];
+			siftUp(position);
+			siftDown(positions[handle_moved]);
+		}
+	}
+
+	void Event_heap::update(const int handle, const double time) {
+		if (handle >= (int)positions.size()) {
+			positions.resize(handle + 1, -1);
+		}
+		int position = positions[handle];
+		if (position < 0) {
+			position = (int)handles.size();
+			times.push_back(time);
+			handles.push_back(handle);
+			positions[handle] = position;
+			siftUp(position);
+			return;
+		}
+		const double time_prev = times[position];
+		times[position] = time;
+		if (time < time_prev) {
+			siftUp(position);
+		}
+		else {
+			siftDown(position);
+		}
+	}
+
+	void Event_heap::siftUp(int position) {
+		while (position > 0) {
+			const int parent = (position - 1) / 2;
+			if (!(times[position] < times[parent])) {
+				break;
+			}
+			swapEntries(position, parent);
+			position = parent;
+		}
+	}
+
+	void Event_heap::siftDown(int position) {
+		const int N = (int)handles.size();
+		while (true) {
+			const int left = 2 * position + 1;
+			if (left >= N) {
+				break;
+			}
+			const int right = left + 1;
+			const int child = (right < N && times[right] < times[left]) ? right : left;
+			if (!(times[child] < times[position])) {
+				break;
+			}
+			swapEntries(position, child);
+			position = child;
+		}
+	}
+
+	void Event_heap::swapEntries(const int position1, const int position2) {
+		swap(times[position1], times[position2]);
+		swap(handles[position1], handles[position2]);
+		positions[handles[position1]] = position1;
+		positions[handles[position2]] = position2;
+	}
+
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#ifndef EVENT_HEAP_H
+#define EVENT_HEAP_H
+
+#include <vector>
+
+namespace KMC_Lattice_example {
+
+	// This class stores the execution times of scheduled events in an indexed binary min-heap, so that the earliest event
+	// can be found in O(1) time and an event can be added, rescheduled, or removed in O(log N) time.
+	// Each event is identified by a non-negative integer handle, and the position of each handle in the heap is stored
+	// so that an event never needs to be searched for.  The times and handles are kept in contiguous arrays.
+	class Event_heap {
+	public:
+		// Constructs an empty heap
+		Event_heap() {}
+
+		// Removes all events from the heap
+		void clear();
+
+		// Checks whether the heap contains no events
+		bool empty() const;
+
+		// Gets the handle of the event with the earliest execution time, which must only be called when the heap is not empty
+		int getNextHandle() const;
+
+		// Gets the earliest execution time, which must only be called when the heap is not empty
+		double getNextTime() const;
+
+		// Gets the number of events in the heap
+		int getN_events() const;
+
+		// Checks whether the event with the specified handle is in the heap
+		bool contains(const int handle) const;
+
+		// Removes the event with the specified handle from the heap if it is in the heap
+		void remove(const int handle);
+
+		// Adds the event with the specified handle to the heap or changes its execution time if it is already in the heap
+		void update(const int handle, const double time);
+
+	private:
+		// Execution times and handles of the events in heap order
+		std::vector<double> times;
+		std::vector<int> handles;
+		// Position of each handle in the heap arrays, or -1 if the handle is not in the heap
+		std::vector<int> positions;
+
+		// Moves the entry at the specified position up or down until the heap order is restored
+		void siftUp(int position);
+		void siftDown(int position);
+
+		// Exchanges the entries at the two specified positions
+		void swapEntries(const int position1, const int position2);
+	};
+
+}
+
+#endif // EVENT_HEAP_H
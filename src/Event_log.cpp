@@ -0,0 +1,219 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#include "Event_log.h"
+#include "Binary_io.h"
+#include <cstring>
+
+using namespace std;
+
+namespace KMC_Lattice_example {
+
+	namespace {
+
+		// Identifies the event log file format, which changes whenever the layout of the data changes
+		const char Log_identifier[8] = { 'K', 'M', 'C', 'E', 'V', 'L', 'O', 'G' };
+		const int Log_version = 1;
+
+		// Appends a signed integer to the buffer as a zigzag-encoded variable-length integer, which uses one byte for each
+		// seven bits so that small differences only need one byte
+		void appendVarint(vector<char>& buffer, const long int value) {
+			unsigned long int encoded = ((unsigned long int)value << 1) ^ (unsigned long int)(value >> 63);
+			while (encoded >= 0x80) {
+				buffer.push_back((char)(encoded | 0x80));
+				encoded >>= 7;
+			}
+			buffer.push_back((char)encoded);
+		}
+
+		// Reads a zigzag-encoded variable-length integer from the buffer and advances the position
+		// Returns false if the buffer ends before the integer is complete.
+		bool readVarint(const vector<char>& buffer, size_t& position, long int& value) {
+			unsigned long int encoded = 0;
+			for (int shift = 0; shift < 64; shift += 7) {
+				if (position >= buffer.size()) {
+					return false;
+				}
+				unsigned char byte = (unsigned char)buffer[position++];
+				encoded |= (unsigned long int)(byte & 0x7F) << shift;
+				if (!(byte & 0x80)) {
+					value = (long int)(encoded >> 1) ^ -(long int)(encoded & 1);
+					return true;
+				}
+			}
+			return false;
+		}
+
+	}
+
+	Event_log::~Event_log() {
+		close();
+	}
+
+	bool Event_log::open(const string& filename, const bool Enable_compression_in) {
+		close();
+		file.open(filename, ofstream::binary | ofstream::trunc);
+		if (!file) {
+			return false;
+		}
+		file.write(Log_identifier, sizeof(Log_identifier));
+		writeBinary(file, Log_version);
+		writeBinary(file, Enable_compression_in);
+		Enable_compression = Enable_compression_in;
+		is_closing = false;
+		write_error = !file.good();
+		blocks.assign(N_blocks, vector<Event_record>(Block_size));
+		block_current = 0;
+		N_records_current = 0;
+		blocks_full.clear();
+		blocks_free.clear();
+		for (int i = N_blocks - 1; i > 0; i--) {
+			blocks_free.push_back(i);
+		}
+		writer = thread(&Event_log::runWriter, this);
+		is_open = true;
+		return true;
+	}
+
+	bool Event_log::close() {
+		if (!is_open) {
+			return true;
+		}
+		// Hand the partially filled block to the writer thread and wait for all blocks to be written
+		{
+			lock_guard<std::mutex> lock(mutex);
+			if (N_records_current > 0) {
+				blocks_full.emplace_back(block_current, N_records_current);
+				N_records_current = 0;
+			}
+			is_closing = true;
+		}
+		condition.notify_all();
+		writer.join();
+		file.close();
+		blocks.clear();
+		is_open = false;
+		return !write_error && !file.fail();
+	}
+
+	void Event_log::submitBlock() {
+		unique_lock<std::mutex> lock(mutex);
+		blocks_full.emplace_back(block_current, N_records_current);
+		condition.notify_all();
+		condition.wait(lock, [this] { return !blocks_free.empty(); });
+		block_current = blocks_free.back();
+		blocks_free.pop_back();
+		N_records_current = 0;
+	}
+
+	// The records are encoded and written without holding the lock, so the simulation thread can keep filling other blocks
+	void Event_log::runWriter() {
+		vector<char> buffer;
+		unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			condition.wait(lock, [this] { return !blocks_full.empty() || is_closing; });
+			if (blocks_full.empty()) {
+				break;
+			}
+			auto block = blocks_full.front();
+			blocks_full.pop_front();
+			lock.unlock();
+			writeBlock(blocks[block.first].data(), block.second, buffer);
+			lock.lock();
+			blocks_free.push_back(block.first);
+			condition.notify_all();
+		}
+	}
+
+	void Event_log::writeBlock(const Event_record* records, const int N_records, vector<char>& buffer) {
+		buffer.clear();
+		if (!Enable_compression) {
+			buffer.resize(N_records * sizeof(Event_record));
+			memcpy(buffer.data(), records, buffer.size());
+		}
+		// The times are stored unchanged, the tag and initial coordinates are stored as differences from the previous record,
+		// and the destination coordinates are stored as differences from the initial coordinates
+		else {
+			Event_record previous = {};
+			for (int i = 0; i < N_records; i++) {
+				const Event_record& record = records[i];
+				const char* time_bytes = reinterpret_cast<const char*>(&record.time);
+				buffer.insert(buffer.end(), time_bytes, time_bytes + sizeof(double));
+				appendVarint(buffer, record.event_code);
+				appendVarint(buffer, (long int)record.tag - previous.tag);
+				appendVarint(buffer, (long int)record.x_initial - previous.x_initial);
+				appendVarint(buffer, (long int)record.y_initial - previous.y_initial);
+				appendVarint(buffer, (long int)record.z_initial - previous.z_initial);
+				appendVarint(buffer, (long int)record.x_dest - record.x_initial);
+				appendVarint(buffer, (long int)record.y_dest - record.y_initial);
+				appendVarint(buffer, (long int)record.z_dest - record.z_initial);
+				previous = record;
+			}
+		}
+		writeBinary(file, N_records);
+		writeBinary(file, (long int)buffer.size());
+		file.write(buffer.data(), buffer.size());
+		if (!file.good()) {
+			write_error = true;
+		}
+	}
+
+	bool Event_log::readHeader(ifstream& file, bool& Enable_compression) {
+		char identifier[sizeof(Log_identifier)];
+		int version = 0;
+		file.read(identifier, sizeof(identifier));
+		if (!file.good() || memcmp(identifier, Log_identifier, sizeof(Log_identifier)) != 0) {
+			return false;
+		}
+		return readBinary(file, version) && version == Log_version && readBinary(file, Enable_compression);
+	}
+
+	bool Event_log::readBlock(ifstream& file, const bool Enable_compression, vector<Event_record>& records) {
+		int N_records = 0;
+		long int N_bytes = 0;
+		if (!readBinary(file, N_records) || !readBinary(file, N_bytes) || N_records < 0 || N_bytes < 0) {
+			return false;
+		}
+		vector<char> buffer(N_bytes);
+		file.read(buffer.data(), N_bytes);
+		if (!file.good()) {
+			return false;
+		}
+		records.resize(N_records);
+		if (!Enable_compression) {
+			if (N_bytes != (long int)(N_records * sizeof(Event_record))) {
+				return false;
+			}
+			memcpy(records.data(), buffer.data(), N_bytes);
+			return true;
+		}
+		Event_record previous = {};
+		size_t position = 0;
+		for (auto& record : records) {
+			long int values[8];
+			if (position + sizeof(double) > buffer.size()) {
+				return false;
+			}
+			memcpy(&record.time, buffer.data() + position, sizeof(double));
+			position += sizeof(double);
+			for (auto& value : values) {
+				if (!readVarint(buffer, position, value)) {
+					return false;
+				}
+			}
+			record.event_code = (int)values[0];
+			record.tag = (int)(previous.tag + values[1]);
+			record.x_initial = (int)(previous.x_initial + values[2]);
+			record.y_initial = (int)(previous.y_initial + values[3]);
+			record.z_initial = (int)(previous.z_initial + values[4]);
+			record.x_dest = (int)(record.x_initial + values[5]);
+			record.y_dest = (int)(record.y_initial + values[6]);
+			record.z_dest = (int)(record.z_initial + values[7]);
+			previous = record;
+		}
+		return position == buffer.size();
+	}
+
+}
@@ -0,0 +1,109 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace KMC_Lattice_example {
+
+	// Stores one executed event in the event log with a fixed size of 40 bytes
+	struct Event_record {
+		double time; // (s)
+		int event_code;
+		int tag;
+		int x_initial;
+		int y_initial;
+		int z_initial;
+		int x_dest;
+		int y_dest;
+		int z_dest;
+	};
+
+	// This class writes a binary log of executed events from one simulation.  The records are collected in a ring of
+	// fixed-size blocks, and each full block is handed to a background writer thread that encodes it and writes it to
+	// the log file, so the simulation thread only copies each record into memory.  The simulation thread only waits
+	// when all blocks are waiting to be written.
+	// The log file starts with a header that contains a format identifier, the format version, and the compression flag,
+	// followed by the blocks.  Each block starts with its number of records and its number of bytes.  Without compression,
+	// a block contains the raw records.  With compression, the fields of each record are stored as variable-length integer
+	// differences from the previous record in the block, which typically reduces the size of the log by more than half.
+	class Event_log {
+	public:
+		// Number of records in each block and number of blocks in the ring
+		static constexpr int Block_size = 32768;
+		static constexpr int N_blocks = 4;
+
+		// Constructs a closed event log
+		Event_log() {}
+
+		// The destructor closes the log if it is still open
+		~Event_log();
+
+		// Creates the log file with the specified name and starts the writer thread.  Returns false if the file cannot be created.
+		bool open(const std::string& filename, const bool Enable_compression);
+
+		// Writes all remaining records, stops the writer thread, and closes the log file.  Returns false if any write failed.
+		bool close();
+
+		// Checks whether the log is open
+		bool isOpen() const { return is_open; }
+
+		// Adds one record to the current block, which is handed to the writer thread once it is full
+		// This function is defined in the header so that it can be inlined into the event execution functions.
+		void addRecord(const Event_record& record) {
+			blocks[block_current][N_records_current++] = record;
+			if (N_records_current == Block_size) {
+				submitBlock();
+			}
+		}
+
+		// Reads the header of a log file and gets the compression flag.  Returns false if the file is not a valid event log.
+		static bool readHeader(std::ifstream& file, bool& Enable_compression);
+
+		// Reads and decodes the next block of a log file into the records vector.  Returns false at the end of the file or
+		// if the block is incomplete.
+		static bool readBlock(std::ifstream& file, const bool Enable_compression, std::vector<Event_record>& records);
+
+	private:
+		bool is_open = false;
+		bool Enable_compression = false;
+		bool is_closing = false;
+		bool write_error = false;
+		std::ofstream file;
+		std::thread writer;
+		std::mutex mutex;
+		std::condition_variable condition;
+
+		// Ring of record blocks, the block that is currently being filled, and the number of records in it
+		std::vector<std::vector<Event_record>> blocks;
+		int block_current = 0;
+		int N_records_current = 0;
+
+		// Indices and record counts of the full blocks waiting to be written, and indices of the free blocks
+		std::deque<std::pair<int, int>> blocks_full;
+		std::vector<int> blocks_free;
+
+		// Hands the current block to the writer thread and waits for a free block to continue filling
+		void submitBlock();
+
+		// Main function of the writer thread, which writes full blocks until the log is closed
+		void runWriter();
+
+		// Encodes the specified records and writes them to the log file as one block
+		void writeBlock(const Event_record* records, const int N_records, std::vector<char>& buffer);
+	};
+
+}
+
+#endif // EVENT_LOG_H
@@ -9,6 +9,7 @@
 #include "Utils.h"
 #include "Object.h"
 #include "Event.h"
+#include <algorithm>
 #include <string>
 
 namespace KMC_Lattice_example {
@@ -20,18 +21,48 @@ namespace KMC_Lattice_example {
 		static const std::string object_type;
 
 		// Derived object constructors must call the base class constructor as well.
-		Exciton(const double time, const int tag_num, const KMC_Lattice::Coords& start_coords) : Object(time, tag_num, start_coords) {}
+		Exciton(const double time, const int tag_num, const KMC_Lattice::Coords& start_coords) : Object(time, tag_num, start_coords), creation_coords(start_coords) {}
 		
 		// Derived object classes must define the getObjectType function to retrieve the static object type string.
 		std::string getObjectType() const { return object_type; }
 
+		// Gets the coordinates where the exciton was created.
+		KMC_Lattice::Coords getCreationCoords() const { return creation_coords; }
+
+		// Gets the index of the storage slot that holds this exciton and its events in the simulation.
+		int getSlotIndex() const { return slot_index; }
+
+		// Sets the index of the storage slot that holds this exciton and its events in the simulation.
+		void setSlotIndex(const int index) { slot_index = index; }
+
 		// -----------------------------------------------------------------------------------------------
 		// Object event classes - One should declare all derived event classes for each type of event
 		// that the derived object can perform within the derived object class with public scope.
 		// -----------------------------------------------------------------------------------------------
 
+		// Integer codes that identify each of the exciton event classes below.  The simulation uses these
+		// codes to dispatch events with a switch statement, while the event type strings are kept for logging.
+		enum class Event_code { Creation, Hop, Recombination };
+
+		// This intermediate event class stores the Event_code of the derived exciton event class, so that the
+		// type of an event can be determined from an Event base class pointer without a virtual function call 
+		// or a string copy. All exciton event classes derive from it.
+		class Coded_event : public KMC_Lattice::Event {
+		public:
+			// Constructs an empty event that is uninitialized. 
+			Coded_event(const Event_code code) : KMC_Lattice::Event(), event_code(code) {}
+
+			// Constructs and initializes an event with the specified event code.
+			Coded_event(KMC_Lattice::Simulation* sim_ptr, const Event_code code) : KMC_Lattice::Event(sim_ptr), event_code(code) {}
+
+			// Gets the code that identifies the derived event class.
+			Event_code getEventCode() const { return event_code; }
+		private:
+			Event_code event_code;
+		};
+
 		// This derived event class represents an exciton creation event
-		class Creation : public KMC_Lattice::Event {
+		class Creation : public Coded_event {
 		public:
 			// Derived event classes must have a static constant string variable that will be set to a 
 			// unique name for identifying different event types when given only an Event base class pointer.
@@ -39,11 +70,11 @@ namespace KMC_Lattice_example {
 
 			// Constructs an empty event that is uninitialized. 
 			// Derived event constructors must call the base class constructor.
-			Creation() : KMC_Lattice::Event() {}
+			Creation() : Coded_event(Event_code::Creation) {}
 
 			// Constructs and initializes an exciton creation event. 
 			// Derived event constructors must call the base class constructor.
-			Creation(KMC_Lattice::Simulation* sim_ptr) : KMC_Lattice::Event(sim_ptr) {}
+			Creation(KMC_Lattice::Simulation* sim_ptr) : Coded_event(sim_ptr, Event_code::Creation) {}
 
 			// Derived event classes must define the getEventType function to retrieve the static event type string.
 			std::string getEventType() const { return event_type; }
@@ -52,7 +83,7 @@ namespace KMC_Lattice_example {
 		};
 
 		// This derived event class represents an exciton hop (move) event
-		class Hop : public KMC_Lattice::Event {
+		class Hop : public Coded_event {
 		public:
 			// Derived event classes must have a static constant string variable that will be set to a 
 			// unique name for identifying different event types when given only an Event base class pointer.
@@ -60,16 +91,16 @@ namespace KMC_Lattice_example {
 
 			// Constructs and initializes an exciton hop event. 
 			// Derived event constructors must call the base class constructor.
-			Hop(KMC_Lattice::Simulation* sim_ptr) : KMC_Lattice::Event(sim_ptr) {}
+			Hop(KMC_Lattice::Simulation* sim_ptr) : Coded_event(sim_ptr, Event_code::Hop) {}
 
 			// Derived event classes can have custom calculateRateConstant functions that allows users
 			// to implement complex rate equations for the event
-			// Here this exciton hop event implements a Forster resonant energy transfer mechanism rate equation.
-			void calculateRateConstant(const double prefactor, const double distance, const double E_delta) {
-				rate_constant = prefactor * KMC_Lattice::intpow(1.0 / distance, 6);
-				if (E_delta > 0) {
-					rate_constant *= exp(-E_delta / (KMC_Lattice::K_b*sim_ptr->getTemp()));
-				}
+			// Here this exciton hop event implements a Forster resonant energy transfer mechanism rate equation,
+			// where the distance dependent prefactor, R_hop*(1/r)^6, has already been calculated for the hop.
+			// The Boltzmann factor for uphill hops, exp(-E_delta/(K_b*T)), is given by the ratio of the Boltzmann
+			// weights of the destination and initial sites, which is greater than one for downhill hops.
+			void calculateRateConstant(const double prefactor, const double weight_ratio) {
+				rate_constant = prefactor * std::min(1.0, weight_ratio);
 			}
 
 			// Derived event classes must define the getEventType function to retrieve the static event type string.
@@ -79,7 +110,7 @@ namespace KMC_Lattice_example {
 		};
 
 		// This derived event class represents an exciton recombination (disappearance) event
-		class Recombination : public KMC_Lattice::Event {
+		class Recombination : public Coded_event {
 		public:
 			// Derived event classes must have a static constant string variable that will be set to a 
 			// unique name for identifying different event types when given only an Event base class pointer.
@@ -87,7 +118,7 @@ namespace KMC_Lattice_example {
 
 			// Constructs and initializes an exciton hop event. 
 			// Derived event constructors must call the base class constructor.
-			Recombination(KMC_Lattice::Simulation* simulation_ptr) : Event(simulation_ptr) {}
+			Recombination(KMC_Lattice::Simulation* simulation_ptr) : Coded_event(simulation_ptr, Event_code::Recombination) {}
 
 			// Derived event classes must define the getEventType function to retrieve the static event type string.
 			std::string getEventType() const { return event_type; }
@@ -96,6 +127,10 @@ namespace KMC_Lattice_example {
 		};
 
 	private:
+		// Coordinates where the exciton was created
+		KMC_Lattice::Coords creation_coords;
+		// Index of the storage slot in the simulation's exciton pool
+		int slot_index = -1;
 	};
 
 }
@@ -4,309 +4,806 @@
 // The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
 
 #include "Exciton_sim.h"
+#include "Binary_io.h"
+#include "Correlated_dos.h"
+#include "Hop_kernel.h"
+#include <complex>
+#include <cstdio>
+#include <fstream>
+#include <thread>
 
 using namespace std;
 using namespace KMC_Lattice;
 
 namespace KMC_Lattice_example {
 
-	Exciton_sim::Exciton_sim(const Parameters& params_in, const int id) {
+	// Identifies the checkpoint file format
+	// The version must be incremented whenever the layout of the checkpoint file changes
+	static const char checkpoint_magic[8] = { 'K', 'M', 'C', 'X', 'C', 'K', 'P', 'T' };
+	static const int checkpoint_version = 8;
+
+	Exciton_sim::Exciton_sim(const Parameters& params_in, const int id, const Energy_landscape* landscape_ptr_in) {
 		// Check validity of input parameters
 		if (!params_in.checkParameters()) {
 			throw invalid_argument("Error! Cannot create Exciton_sim object because the input parameters are invalid.");
 		}
+		if (landscape_ptr_in != nullptr && (landscape_ptr_in->getLength() != params_in.Params_lattice.Length || landscape_ptr_in->getWidth() != params_in.Params_lattice.Width || landscape_ptr_in->getHeight() != params_in.Params_lattice.Height || landscape_ptr_in->getUnitSize() != params_in.Params_lattice.Unit_size)) {
+			throw invalid_argument("Error! Cannot create Exciton_sim object because the energy landscape does not match the lattice parameters.");
+		}
 		// Set Parameters member variable
 		params = params_in;
+		landscape_ptr = landscape_ptr_in;
+		N_tests_target = params.N_tests;
 		// Set parameters of Simulation base class using the init function
 		// Can pass derived Parameters class object and the underlying Parameters_ Simulation base class will be used
 		init(params, id);
+		// Set up the counter-based random number streams of this simulation
+		random_seed = (params.Random_seed > 0) ? params.Random_seed : generator();
+		rng_site_energies = Random_stream(random_seed, (unsigned int)id, (unsigned int)Random_purpose::Site_energies);
+		seedEventStreams(random_seed);
 		// Initialize lattice sites
-		sites.assign(lattice.getNumSites(), Site_OSC());
-		// Create vector of site energies using Utils density of states creation functions
-		vector<double> site_energies(lattice.getNumSites());
-		if (params.Enable_gaussian_dos) {
-			createGaussianDOSVector(site_energies, 0.0, params.Site_energy_stdev, generator);
+		// In the sparse site storage mode, no site data is stored and the site energies are calculated when they are needed
+		// When an energy landscape is used, only the site occupancy needs to be stored
+		if (landscape_ptr != nullptr && !params.Enable_sparse_sites) {
+			site_occupancy_compact.assign(lattice.getNumSites(), false);
+		}
+		else if (params.Enable_compact_sites && !params.Enable_sparse_sites) {
+			site_occupancy_compact.assign(lattice.getNumSites(), false);
+			site_energies_compact.assign(lattice.getNumSites(), 0.0f);
+			site_weights_compact.resize(lattice.getNumSites());
 		}
-		else if (params.Enable_exponential_dos) {
-			createExponentialDOSVector(site_energies, 0.0, params.Site_energy_urbach, generator);
+		else if (!params.Enable_sparse_sites) {
+			sites.assign(lattice.getNumSites(), Site_OSC());
 		}
-		// Set the site energies
-		if (params.Enable_gaussian_dos || params.Enable_exponential_dos) {
-			for (int i = 0; i < lattice.getNumSites(); i++) {
-				sites[i].setEnergy(site_energies[i]);
+		// Correlated site energies are created for the whole lattice at once by FFT convolution
+		if (params.Enable_correlated_disorder && !params.Enable_sparse_sites && landscape_ptr == nullptr) {
+			vector<double> site_energies;
+			createCorrelatedGaussianDOSVector(site_energies, lattice.getLength(), lattice.getWidth(), lattice.getHeight(), lattice.getUnitSize(), params.Site_energy_stdev, params.Disorder_correlation_length, rng_site_energies, params.N_dos_threads);
+			for (long int i = 0; i < lattice.getNumSites(); i++) {
+				setSiteEnergy(i, site_energies[i]);
 			}
 		}
-		// Set the site pointers for the Lattice object
-		vector<Site*> site_ptrs((int)sites.size());
-		for (int i = 0; i < (int)sites.size(); i++) {
-			site_ptrs[i] = &sites[i];
+		// Otherwise, create the uncorrelated site energies from the site energy stream, so that each site energy only depends on
+		// the site index and is the same as in the sparse site storage mode
+		// The uniform random numbers are drawn in fixed-size batches so that no temporary copy of the whole lattice is needed.
+		else if ((params.Enable_gaussian_dos || params.Enable_exponential_dos) && !params.Enable_sparse_sites && landscape_ptr == nullptr) {
+			const long int chunk_size = 1L << 20;
+			Random_stream stream = rng_site_energies;
+			vector<double> uniforms;
+			for (long int i = 0; i < lattice.getNumSites(); i += chunk_size) {
+				const long int N_chunk = min(chunk_size, lattice.getNumSites() - i);
+				uniforms.resize(2 * N_chunk);
+				stream.generateUniforms(uniforms.data(), (int)uniforms.size());
+				for (long int j = 0; j < N_chunk; j++) {
+					setSiteEnergy(i + j, calculateSiteEnergy(uniforms[2 * j], uniforms[2 * j + 1]));
+				}
+			}
 		}
-		lattice.setSitePointers(site_ptrs);
-		// Initialize the Exciton_Creation event
-		R_exciton_generation = params.Exciton_generation_rate * lattice.getNumSites()*intpow(1e-7*lattice.getUnitSize(), 3);
-		exciton_creation_event = Exciton::Creation(this);
-		exciton_creation_event.calculateExecutionTime(R_exciton_generation);
-		auto exciton_creation_it = addEvent(&exciton_creation_event);
+		// Calculate the Boltzmann weight of each site from its energy
+		calculateBoltzmannWeights();
+		initializeEmptySiteIndex();
+		initializeEvents();
 	}
 
 	double Exciton_sim::calculateDiffusionLength_avg() {
-		return vector_avg(diffusion_distances);
+		return diffusion_stats.getMean();
 	}
 
 	double Exciton_sim::calculateDiffusionLength_stdev() {
-		return vector_stdev(diffusion_distances);
+		return diffusion_stats.getStdev();
 	}
 
 	Coords Exciton_sim::calculateExcitonCreationCoords() {
-		// Faster method of choosing a random site.  This becomes slow when the lattice has high occupancy.
-		// Use faster method when lattice is less than 50% occupied.
-		int N_tries = 0;
-		while (N_excitons < (0.5*lattice.getLength()*lattice.getWidth()*lattice.getHeight()) && N_tries < 10) {
-			auto dest_coords = lattice.generateRandomCoords();
-			if (!lattice.isOccupied(dest_coords)) {
-				return dest_coords;
-			}
-			N_tries++;
-		}
-		// Method of choosing one of the empty sites.  This is slowish becuase it must loop through all sites first
-		// Get vector of possible creation sites
-		vector<long int> indices;
-		indices.reserve(lattice.getLength()*lattice.getWidth()*lattice.getHeight());
-		for (int x = 0; x < lattice.getLength(); x++) {
-			for (int y = 0; y < lattice.getWidth(); y++) {
-				for (int z = 0; z < lattice.getHeight(); z++) {
-					Coords dest_coords(x, y, z);
-					if (!lattice.isOccupied(dest_coords)) {
-						indices.push_back(lattice.getSiteIndex(dest_coords));
-					}
+		// Without the empty site index, random sites are tried until an unoccupied site is found, which is fast at the low
+		// occupancies that compact and sparse site storage are designed for
+		// If all attempts fail, the lattice is nearly full, and one of the empty sites is instead selected by counting the empty
+		// sites in a linear scan, so that each empty site is still equally likely to be chosen.
+		if (params.Enable_compact_sites || params.Enable_sparse_sites) {
+			if (N_excitons >= lattice.getNumSites()) {
+				cout << getId() << ": Error! An empty site for exciton creation could not be found." << endl;
+				return Coords(-1, -1, -1);
+			}
+			uniform_int_distribution<long int> distn(0, lattice.getNumSites() - 1);
+			for (int attempt = 0; attempt < Creation_attempts_max; attempt++) {
+				long int site_index = distn(rng_creation);
+				if (!isSiteOccupied(site_index)) {
+					return lattice.getSiteCoords(site_index);
 				}
 			}
+			uniform_int_distribution<long int> distn_empty(0, lattice.getNumSites() - N_excitons - 1);
+			long int N_empty_skipped = distn_empty(rng_creation);
+			for (long int i = 0; i < lattice.getNumSites(); i++) {
+				if (isSiteOccupied(i)) {
+					continue;
+				}
+				if (N_empty_skipped == 0) {
+					return lattice.getSiteCoords(i);
+				}
+				N_empty_skipped--;
+			}
+			cout << getId() << ": Error! An empty site for exciton creation could not be found." << endl;
+			return Coords(-1, -1, -1);
 		}
-		// Print an error message if no unoccupied sites are found
-		if ((int)indices.size() == 0) {
+		// Print an error message if no unoccupied sites are left
+		if (empty_site_indices.empty()) {
 			cout << getId() << ": Error! An empty site for exciton creation could not be found." << endl;
 			return Coords(-1, -1, -1);
 		}
-		// Randomly select one of the unoccupied sites from the indices vector
-		uniform_int_distribution<long int> distn(0, (long int)indices.size());
-		return lattice.getSiteCoords(indices[distn(generator)]);
+		// Randomly select one of the unoccupied sites from the empty site index
+		uniform_int_distribution<long int> distn(0, (long int)empty_site_indices.size() - 1);
+		return lattice.getSiteCoords(empty_site_indices[distn(rng_creation)]);
+	}
+
+	// The uniform random number is in the interval [0,1), so its complement is used to avoid taking the logarithm of zero
+	void Exciton_sim::calculateExecutionTime(Event& event, const double rate, Random_stream& stream) {
+		event.setExecutionTime(getTime() - log(1.0 - stream.generateUniform()) / rate);
+	}
+
+	void Exciton_sim::seedEventStreams(const uint64_t seed) {
+		rng_creation = Random_stream(seed, (unsigned int)getId(), (unsigned int)Random_purpose::Exciton_creation);
+		rng_events = Random_stream(seed, (unsigned int)getId(), (unsigned int)Random_purpose::Exciton_events);
+	}
+
+	double Exciton_sim::simulateIndependentWalker(Random_stream& walker_stream, vector<double>& prefactors, vector<double>& weights, vector<double>& rates_cumulative) const {
+		// Create the walker on a random site, since all sites are empty in the non-interacting limit
+		uniform_int_distribution<long int> distn_site(0, lattice.getNumSites() - 1);
+		Coords coords = lattice.getSiteCoords(distn_site(walker_stream));
+		const double rate_recombination = 1.0 / params.Exciton_lifetime;
+		// The unwrapped displacement is accumulated from the hop displacements so that hops across periodic boundaries are handled
+		long int dx_total = 0;
+		long int dy_total = 0;
+		long int dz_total = 0;
+		vector<int> candidate_indices(hop_stencil.size());
+		vector<Coords> candidate_coords(hop_stencil.size());
+		while (true) {
+			// Gather the hop candidates, which are all stencil entries that do not cross a hard boundary
+			int N_candidates = 0;
+			for (int n = 0; n < (int)hop_stencil.size(); n++) {
+				const Hop_offset& offset = hop_stencil[n];
+				if (!lattice.checkMoveValidity(coords, offset.dx, offset.dy, offset.dz)) {
+					continue;
+				}
+				lattice.calculateDestinationCoords(coords, offset.dx, offset.dy, offset.dz, candidate_coords[N_candidates]);
+				candidate_indices[N_candidates] = n;
+				prefactors[N_candidates] = offset.prefactor;
+				weights[N_candidates] = getSiteWeight(lattice.getSiteIndex(candidate_coords[N_candidates]));
+				N_candidates++;
+			}
+			const long int site_index_origin = lattice.getSiteIndex(coords);
+			double weight_origin_inv = 1.0 / getSiteWeight(site_index_origin);
+			// When any of the weights may have been limited, the exact Boltzmann factors are passed to the kernel as the
+			// destination weights with a unit initial weight
+			bool is_weight_exact = (weight_origin_inv > Weight_exact_min && weight_origin_inv < Weight_exact_max);
+			for (int m = 0; m < N_candidates && is_weight_exact; m++) {
+				is_weight_exact = (weights[m] > Weight_exact_min && weights[m] < Weight_exact_max);
+			}
+			if (!is_weight_exact) {
+				for (int m = 0; m < N_candidates; m++) {
+					weights[m] = calculateHopFactorExact(lattice.getSiteIndex(candidate_coords[m]), site_index_origin);
+				}
+				weight_origin_inv = 1.0;
+			}
+			// When the random seed is set, the scalar kernel is used so that the walkers do not depend on the vector instructions
+			// supported by the processor
+			const double hop_rate_total = (params.Random_seed > 0) ? calculateHopRatesScalar(prefactors.data(), weights.data(), weight_origin_inv, N_candidates, rates_cumulative.data()) : calculateHopRates(prefactors.data(), weights.data(), weight_origin_inv, N_candidates, rates_cumulative.data());
+			// Select the next event with probability proportional to its rate constant
+			// The event times are not needed because the displacement of the walker does not depend on them
+			const double rate_target = walker_stream.generateUniform()*(hop_rate_total + rate_recombination);
+			if (!(rate_target < hop_rate_total)) {
+				break;
+			}
+			int m = (int)(upper_bound(rates_cumulative.begin(), rates_cumulative.begin() + N_candidates, rate_target) - rates_cumulative.begin());
+			m = min(m, N_candidates - 1);
+			const Hop_offset& offset = hop_stencil[candidate_indices[m]];
+			dx_total += offset.dx;
+			dy_total += offset.dy;
+			dz_total += offset.dz;
+			coords = candidate_coords[m];
+		}
+		return lattice.getUnitSize()*sqrt((double)(dx_total*dx_total + dy_total * dy_total + dz_total * dz_total));
 	}
 
 	// Each object type should have an event calculation function that makes sure all possible event transitions are calculated
+	// The hop rates are taken from the cached hop rate table of the exciton, which must be up to date with the current site occupancy
 	void Exciton_sim::calculateExcitonEvents(Exciton* exciton_ptr) {
 		// Gather information about the exciton
-		const auto exciton_it = getExcitonIt(exciton_ptr);
-		const Coords object_coords = exciton_it->getCoords();
-		// Create vector to store pointers to all possible events that the exciton can perform
-		vector<Event*> possible_events;
-		// Calculate all possible Exciton_Hop events and add their pointers to the possible_events vector
-		// Assess the nearby sites to determine if a hop can occur to them and calculate what is the rate constant for each event
-		static Exciton::Hop event_hop(this);
-		// The exction hop range is calculated in lattice units based on the specified hop cutoff distance in real space units
-		static const int range = (int)ceil((double)params.FRET_cutoff / lattice.getUnitSize());
-		static const int dim = (2 * range + 1);
-		// Use pre-allocated event vector so that all events in the search do not need to be re-created each time the function is called
-		static vector<Exciton::Hop> hops_temp(dim*dim*dim, event_hop);
+		// The slot holding the exciton also holds its paired events and its hop rate table
+		auto& exciton_slot = exciton_slots[exciton_ptr->getSlotIndex()];
+		PROFILE(auto profile_time = Profiler::now());
+		// The global BKL engine only needs the total rate of the exciton, and its next event is selected when the exciton is chosen
+		if (params.Enable_global_bkl) {
+			exciton_rates.setRate(exciton_ptr->getSlotIndex(), exciton_slot.hop_rate_total + exciton_slot.recombination_event.getRateConstant());
+			PROFILE(profiler.lap(Profile_timer::Pathway_selection, profile_time));
+			return;
+		}
+		Event* event_ptr_target;
+		// The first reaction method requires each possible event to be considered separately, so here the hop events are set up 
+		// and the event with the earliest execution time is selected
+		if (params.Enable_FRM) {
+			// The possible events are collected in a pre-allocated work array, so that no memory is allocated for each exciton
+			auto& possible_events = possible_events_temp;
+			possible_events.clear();
+			for (int n = 0; n < (int)hop_stencil.size(); n++) {
+				// Hops that are not possible have a zero destination weight in the hop rate table
+				if (!(exciton_slot.hop_weights[n] > 0)) {
+					continue;
+				}
+				const Hop_offset& offset = hop_stencil[n];
+				auto& hop_event = hops_temp[n];
+				// Must specify which object the event is associated with
+				hop_event.setObjectPtr(exciton_ptr);
+				// Must specify the event destination coords
+				Coords dest_coords;
+				lattice.calculateDestinationCoords(exciton_ptr->getCoords(), offset.dx, offset.dy, offset.dz, dest_coords);
+				hop_event.setDestCoords(dest_coords);
+				// Must calculate the event rate constant
+				hop_event.calculateRateConstant(offset.prefactor, getHopFactor(exciton_slot, n));
+				// Save the calculated exciton hop event as a possible event by adding its pointer to the possible_events vector
+				possible_events.push_back(&hop_event);
+			}
+			// Also include the Exciton_Recombination event that is paired with this exciton
+			possible_events.push_back(&exciton_slot.recombination_event);
+			// The uniform random numbers for the waiting times of all possible events are drawn in one batch, and the event with
+			// the earliest execution time is selected
+			rng_events.generateUniforms(uniforms_temp.data(), (int)possible_events.size());
+			event_ptr_target = nullptr;
+			double execution_time_min = 0.0;
+			for (int n = 0; n < (int)possible_events.size(); n++) {
+				const double execution_time = getTime() - log(1.0 - uniforms_temp[n]) / possible_events[n]->getRateConstant();
+				if (event_ptr_target == nullptr || execution_time < execution_time_min) {
+					event_ptr_target = possible_events[n];
+					execution_time_min = execution_time;
+				}
+			}
+			event_ptr_target->setExecutionTime(execution_time_min);
+			// For hop events, copy the selected temp event to the hop event in the exciton's slot
+			// Then set the target event pointer to the hop event from the slot
+			// All events in this simulation are exciton events, so the selected event type can be determined from its event code
+			exciton_slot.selected_event_code = static_cast<Exciton::Coded_event*>(event_ptr_target)->getEventCode();
+			if (exciton_slot.selected_event_code == Exciton::Event_code::Hop) {
+				exciton_slot.hop_event = *static_cast<Exciton::Hop*>(event_ptr_target);
+				event_ptr_target = &exciton_slot.hop_event;
+			}
+		}
+		// The BKL algorithm selects one event with probability proportional to its rate constant directly from the cumulative rates
+		// The execution time of the selected event is then calculated using the total rate constant of all possible events
+		else {
+			event_ptr_target = selectExcitonEvent(exciton_slot);
+			calculateExecutionTime(*event_ptr_target, exciton_slot.hop_rate_total + exciton_slot.recombination_event.getRateConstant(), rng_events);
+		}
+		// With the event heap scheduler, the execution time of the selected event is stored in the heap with the slot index plus
+		// one as the handle, because handle 0 is used for the exciton creation event
+		if (params.Enable_event_heap) {
+			event_schedule.update(exciton_ptr->getSlotIndex() + 1, event_ptr_target->getExecutionTime());
+		}
+		// Otherwise, the selected event is found by chooseNextEventScan from the selected event code of the slot
+		PROFILE(profiler.lap(Profile_timer::Pathway_selection, profile_time));
+	}
+
+	void Exciton_sim::calculateHopRateTable(Exciton_slot& exciton_slot) {
+		// Assess the nearby sites in the hop stencil to determine if a hop can occur to them
+		PROFILE(auto profile_time = Profiler::now());
+		// Use the neighbor scan specialization selected for the lattice boundary conditions and the hop range
+		(this->*scan_hop_stencil)(exciton_slot);
+		exciton_slot.weight_origin_inv = 1.0 / getSiteWeightCached(lattice.getSiteIndex(exciton_slot.exciton.getCoords()));
+		PROFILE(profiler.lap(Profile_timer::Neighbor_scan, profile_time));
+		// Calculate the hop rates from scratch and rebuild the Fenwick tree of the exciton
+		const int N_stencil = (int)hop_stencil.size();
+		for (int n = 0; n < N_stencil; n++) {
+			hop_rates_temp[n] = hop_prefactors[n] * getHopFactor(exciton_slot, n);
+		}
+		exciton_slot.hop_rates.setRates(hop_rates_temp.data(), N_stencil);
+		exciton_slot.hop_rate_total = exciton_slot.hop_rates.getTotal();
+		PROFILE(profiler.lap(Profile_timer::Rate_calculation, profile_time));
+	}
+
+	namespace {
+
+		// Moves the coordinate along an axis with the specified size back into the lattice if the axis is periodic
+		// Returns false if the coordinate is outside of the lattice along a non-periodic axis.
+		template<bool Periodic>
+		inline bool wrapCoordinate(int& value, const int size) {
+			if (value >= 0 && value < size) {
+				return true;
+			}
+			if (!Periodic) {
+				return false;
+			}
+			// The remainder is used so that lattices that are smaller than the hop range are also wrapped correctly
+			value = ((value % size) + size) % size;
+			return true;
+		}
+
+	}
+
+	// The site index is calculated directly from the coordinates, where z varies fastest and x varies slowest, as in the Lattice class
+	// Hops that cross a non-periodic boundary and hops to occupied sites keep a zero weight in the hop rate table.
+	template<bool Periodic_x, bool Periodic_y, bool Periodic_z, int Range>
+	void Exciton_sim::scanHopStencil(Exciton_slot& exciton_slot) {
+		const int range = (Range > 0) ? Range : hop_range;
+		const int stencil_width = 2 * range + 1;
+		const int length = lattice.getLength();
+		const int width = lattice.getWidth();
+		const int height = lattice.getHeight();
+		const long int plane = (long int)width * height;
+		const Coords& coords = exciton_slot.exciton.getCoords();
+		const bool is_interior = coords.x >= range && coords.x < length - range && coords.y >= range && coords.y < width - range && coords.z >= range && coords.z < height - range;
+		exciton_slot.hop_weights.assign(hop_stencil.size(), 0.0);
+		double* hop_weights = exciton_slot.hop_weights.data();
+		const int* lookup = hop_stencil_lookup.data();
 		for (int i = -range; i <= range; i++) {
+			int x = coords.x + i;
+			if (!is_interior && !wrapCoordinate<Periodic_x>(x, length)) {
+				continue;
+			}
 			for (int j = -range; j <= range; j++) {
+				int y = coords.y + j;
+				if (!is_interior && !wrapCoordinate<Periodic_y>(y, width)) {
+					continue;
+				}
+				const long int row_index = x * plane + (long int)y * height;
+				const int* lookup_row = lookup + ((i + range) * stencil_width + j + range) * stencil_width + range;
 				for (int k = -range; k <= range; k++) {
-					// Use the Lattice class checkMoveValidity function to see if a move with displacement (i,j,k) is possible
-					// This checks for hard boundaries and site occupation
-					if (!lattice.checkMoveValidity(object_coords, i, j, k)) {
+					const int n = lookup_row[k];
+					if (n < 0) {
 						continue;
 					}
-					// Use the Lattice class calculateDestinationCoords functions to determine the destination coordinates of the proposed move
-					// This automatically accounts for hops across periodic boundaries
-					Coords dest_coords;
-					lattice.calculateDestinationCoords(object_coords, i, j, k, dest_coords);
-					// Use the Lattice class isOccupied function to check if the site at the destination coordinates is unoccupied
-					if (lattice.isOccupied(dest_coords)) {
+					int z = coords.z + k;
+					if (!is_interior && !wrapCoordinate<Periodic_z>(z, height)) {
 						continue;
 					}
-					// Calculate the real space distance of the proposed move in nm
-					double distance = lattice.getUnitSize()*sqrt((double)(i*i + j * j + k * k));
-					// Save the move as a possible event only if the move distance is less than the specified cutoff distance
-					if (!((distance - 0.0001) > params.FRET_cutoff)) {
-						// Calclate the vector index for the corresponding event
-						int index = (i + range)*dim*dim + (j + range)*dim + (k + range);
-						// Must specify which object the event is associated with
-						hops_temp[index].setObjectPtr(exciton_ptr);
-						// Must specify the event destination coords
-						hops_temp[index].setDestCoords(dest_coords);
-						// Must calculate the event rate constant
-						double E_delta = (getSiteEnergy(dest_coords) - getSiteEnergy(object_coords));
-						hops_temp[index].calculateRateConstant(params.R_exciton_hopping, distance, E_delta);
-						// Save the calculated exciton hop event as a possible event by adding its pointer to the possible_events vector
-						possible_events.push_back(&hops_temp[index]);
+					const long int site_index = row_index + z;
+					if (!isSiteOccupied(site_index)) {
+						hop_weights[n] = getSiteWeightCached(site_index);
 					}
 				}
 			}
 		}
-		// Also include the Exciton_Recombination event
-		// Find the recombination event that is paried with this exciton
-		auto recombination_event_it = exciton_recombination_events.begin();
-		advance(recombination_event_it, std::distance(excitons.begin(), exciton_it));
-		// Save the calculated exciton recombination event as a possible event by adding its pointer to the possible_events vector
-		possible_events.push_back(&*recombination_event_it);
-		// Use Simulation class determinePathway function to select which event will be next
-		// This function uses the BKL algorithm to determine which event will be selected
-		Event* event_ptr_target = determinePathway(possible_events);
-		// Determine what is the selected event type
-		string event_type = event_ptr_target->getEventType();
-		// For hop events, copy the selected temp event to the main event list
-		// Then set the target event pointer to the corresponding event from the main list
-		if (event_type.compare(Exciton::Hop::event_type) == 0) {
-			auto hop_list_it = exciton_hop_events.begin();
-			std::advance(hop_list_it, std::distance(excitons.begin(), exciton_it));
-			*hop_list_it = *static_cast<Exciton::Hop*>(event_ptr_target);
-			event_ptr_target = &(*hop_list_it);
-		}
-		// Set the selected event for the exciton using the Simulation class setObjectEvent function
-		setObjectEvent(exciton_ptr, event_ptr_target);
+	}
+
+	// The dispatch table has one scanHopStencil specialization for each combination of periodic axes and for the hop ranges of
+	// one to three lattice units, and the specializations with a runtime hop range are used for longer hop ranges
+	void Exciton_sim::selectHopStencilScan() {
+		typedef void (Exciton_sim::*Scan_function)(Exciton_slot&);
+		static const Scan_function scan_functions[2][2][2][4] = {
+			{ { { &Exciton_sim::scanHopStencil<false, false, false, 0>, &Exciton_sim::scanHopStencil<false, false, false, 1>, &Exciton_sim::scanHopStencil<false, false, false, 2>, &Exciton_sim::scanHopStencil<false, false, false, 3> },
+				{ &Exciton_sim::scanHopStencil<false, false, true, 0>, &Exciton_sim::scanHopStencil<false, false, true, 1>, &Exciton_sim::scanHopStencil<false, false, true, 2>, &Exciton_sim::scanHopStencil<false, false, true, 3> } },
+				{ { &Exciton_sim::scanHopStencil<false, true, false, 0>, &Exciton_sim::scanHopStencil<false, true, false, 1>, &Exciton_sim::scanHopStencil<false, true, false, 2>, &Exciton_sim::scanHopStencil<false, true, false, 3> },
+				{ &Exciton_sim::scanHopStencil<false, true, true, 0>, &Exciton_sim::scanHopStencil<false, true, true, 1>, &Exciton_sim::scanHopStencil<false, true, true, 2>, &Exciton_sim::scanHopStencil<false, true, true, 3> } } },
+			{ { { &Exciton_sim::scanHopStencil<true, false, false, 0>, &Exciton_sim::scanHopStencil<true, false, false, 1>, &Exciton_sim::scanHopStencil<true, false, false, 2>, &Exciton_sim::scanHopStencil<true, false, false, 3> },
+				{ &Exciton_sim::scanHopStencil<true, false, true, 0>, &Exciton_sim::scanHopStencil<true, false, true, 1>, &Exciton_sim::scanHopStencil<true, false, true, 2>, &Exciton_sim::scanHopStencil<true, false, true, 3> } },
+				{ { &Exciton_sim::scanHopStencil<true, true, false, 0>, &Exciton_sim::scanHopStencil<true, true, false, 1>, &Exciton_sim::scanHopStencil<true, true, false, 2>, &Exciton_sim::scanHopStencil<true, true, false, 3> },
+				{ &Exciton_sim::scanHopStencil<true, true, true, 0>, &Exciton_sim::scanHopStencil<true, true, true, 1>, &Exciton_sim::scanHopStencil<true, true, true, 2>, &Exciton_sim::scanHopStencil<true, true, true, 3> } } }
+		};
+		const int range_index = (hop_range >= 1 && hop_range <= 3) ? hop_range : 0;
+		scan_hop_stencil = scan_functions[lattice.isXPeriodic()][lattice.isYPeriodic()][lattice.isZPeriodic()][range_index];
+	}
+
+	// A site can be reached by more than one hop_stencil entry when the lattice is periodic and smaller than the hop range,
+	// so all lattice displacements that lead to the site are updated
+	void Exciton_sim::updateHopRateTable(Exciton_slot& exciton_slot, const Coords& site_coords, const double weight_site) {
+		PROFILE(auto profile_time = Profiler::now());
+		const Coords& object_coords = exciton_slot.exciton.getCoords();
+		// Find the displacements along each axis that lead from the exciton to the site and are within the hop range
+		int displacements[3][3];
+		int N_displacements[3] = { 0, 0, 0 };
+		const int deltas[3] = { site_coords.x - object_coords.x, site_coords.y - object_coords.y, site_coords.z - object_coords.z };
+		const int sizes[3] = { lattice.getLength(), lattice.getWidth(), lattice.getHeight() };
+		const bool periodic[3] = { lattice.isXPeriodic(), lattice.isYPeriodic(), lattice.isZPeriodic() };
+		for (int axis = 0; axis < 3; axis++) {
+			for (int shift = -1; shift <= 1; shift++) {
+				if (shift != 0 && !periodic[axis]) {
+					continue;
+				}
+				int delta = deltas[axis] + shift * sizes[axis];
+				if (abs(delta) <= hop_range) {
+					displacements[axis][N_displacements[axis]++] = delta;
+				}
+			}
+		}
+		const int width = 2 * hop_range + 1;
+		for (int i = 0; i < N_displacements[0]; i++) {
+			for (int j = 0; j < N_displacements[1]; j++) {
+				for (int k = 0; k < N_displacements[2]; k++) {
+					int n = hop_stencil_lookup[((displacements[0][i] + hop_range)*width + displacements[1][j] + hop_range)*width + displacements[2][k] + hop_range];
+					if (n < 0) {
+						continue;
+					}
+					// Update the rate of the hop in the Fenwick tree
+					exciton_slot.hop_weights[n] = weight_site;
+					exciton_slot.hop_rates.setRate(n, hop_stencil[n].prefactor * getHopFactor(exciton_slot, n));
+				}
+			}
+		}
+		exciton_slot.hop_rate_total = exciton_slot.hop_rates.getTotal();
+		PROFILE(profiler.lap(Profile_timer::Rate_update, profile_time));
+	}
+
+	// When several events have the same execution time, the exciton creation event is chosen first and then the exciton in the
+	// lowest slot
+	Event* Exciton_sim::chooseNextEventScan() {
+		Event* event_ptr = &exciton_creation_event;
+		for (auto& exciton_slot : exciton_slots) {
+			if (!exciton_slot.is_active) {
+				continue;
+			}
+			Event* event_ptr_slot = (exciton_slot.selected_event_code == Exciton::Event_code::Hop) ? (Event*)&exciton_slot.hop_event : (Event*)&exciton_slot.recombination_event;
+			if (event_ptr_slot->getExecutionTime() < event_ptr->getExecutionTime()) {
+				event_ptr = event_ptr_slot;
+			}
+		}
+		return event_ptr;
+	}
+
+	// The total rate of all possible events is the exciton creation rate plus the sum of the total rates of all excitons
+	Event* Exciton_sim::chooseNextEventGlobal() {
+		PROFILE(auto profile_time = Profiler::now());
+		const double rate_total = R_exciton_generation + exciton_rates.getTotal();
+		// Advance the simulation time by an exponentially distributed waiting time based on the total rate
+		setTime(getTime() - log(1.0 - rng_events.generateUniform()) / rate_total);
+		N_events_executed_direct++;
+		// Select the exciton creation event or one of the excitons with probability proportional to its total rate
+		const double rate_target = rng_events.generateUniform()*rate_total;
+		const int slot_index = (rate_target < R_exciton_generation) ? -1 : exciton_rates.findIndex(rate_target - R_exciton_generation);
+		if (slot_index < 0) {
+			PROFILE(profiler.lap(Profile_timer::Pathway_selection, profile_time));
+			return &exciton_creation_event;
+		}
+		// Select one of the events of the selected exciton from its hop rate table
+		Event* event_ptr = selectExcitonEvent(exciton_slots[slot_index]);
+		PROFILE(profiler.lap(Profile_timer::Pathway_selection, profile_time));
+		return event_ptr;
+	}
+
+	Event* Exciton_sim::selectExcitonEvent(Exciton_slot& exciton_slot) {
+		// The hop rates are kept up to date in the Fenwick tree of the exciton by the table updates, so the selection takes
+		// O(log N) time
+		const double hop_rate_total = exciton_slot.hop_rate_total;
+		const double rate_total = hop_rate_total + exciton_slot.recombination_event.getRateConstant();
+		const double rate_target = rng_events.generateUniform()*rate_total;
+		// Include the Exciton_Recombination event that is paired with this exciton after all of the hop events
+		if (!(rate_target < hop_rate_total)) {
+			exciton_slot.selected_event_code = Exciton::Event_code::Recombination;
+			return &exciton_slot.recombination_event;
+		}
+		// Otherwise set up the hop event in the exciton's slot with the selected hop
+		// Hops that are not possible have zero rates, so they are never selected
+		const int n = exciton_slot.hop_rates.findIndex(rate_target);
+		if (n < 0) {
+			exciton_slot.selected_event_code = Exciton::Event_code::Recombination;
+			return &exciton_slot.recombination_event;
+		}
+		const Hop_offset& offset = hop_stencil[n];
+		Coords dest_coords;
+		lattice.calculateDestinationCoords(exciton_slot.exciton.getCoords(), offset.dx, offset.dy, offset.dz, dest_coords);
+		exciton_slot.hop_event.setObjectPtr(&exciton_slot.exciton);
+		exciton_slot.hop_event.setDestCoords(dest_coords);
+		exciton_slot.hop_event.calculateRateConstant(offset.prefactor, getHopFactor(exciton_slot, n));
+		exciton_slot.selected_event_code = Exciton::Event_code::Hop;
+		return &exciton_slot.hop_event;
+	}
+
+	// The occupancy of the sites at the initial and destination coordinates has changed, so the hop rate tables of the neighboring
+	// excitons are updated for these sites only, and the hop rate table of an exciton is only calculated from scratch when the exciton
+	// itself has just been created or moved to one of these sites
+	void Exciton_sim::recalculateNeighborEvents(const Coords& coords_initial, const Coords& coords_dest) {
+		// Find the excitons within the recalculation cutoff radius
+		PROFILE(auto profile_time = Profiler::now());
+		findRecalcExcitons(coords_initial, coords_dest);
+		PROFILE(profiler.lap(Profile_timer::Recalc_search, profile_time));
+		PROFILE(profiler.addRecalcNeighbors((long int)recalc_slots.size()));
+		// The destination weight of an occupied site is zero, because no hop can occur to it
+		const bool is_same_site = (coords_initial == coords_dest);
+		const double weight_initial = isSiteOccupied(coords_initial) ? 0.0 : getSiteWeightCached(lattice.getSiteIndex(coords_initial));
+		const double weight_dest = isSiteOccupied(coords_dest) ? 0.0 : getSiteWeightCached(lattice.getSiteIndex(coords_dest));
+		for (int slot_index : recalc_slots) {
+			auto& exciton_slot = exciton_slots[slot_index];
+			Exciton* exciton_ptr = &exciton_slot.exciton;
+			const Coords& object_coords = exciton_ptr->getCoords();
+			if (object_coords == coords_initial || object_coords == coords_dest) {
+				calculateHopRateTable(exciton_slot);
+			}
+			else {
+				updateHopRateTable(exciton_slot, coords_initial, weight_initial);
+				if (!is_same_site) {
+					updateHopRateTable(exciton_slot, coords_dest, weight_dest);
+				}
+			}
+			calculateExcitonEvents(exciton_ptr);
+		}
+	}
+
+	// The recalculation cutoff radius is given in nm, so it is converted to lattice units, and a small tolerance is added so that
+	// excitons exactly at the cutoff radius are included
+	void Exciton_sim::findRecalcExcitons(const Coords& coords_initial, const Coords& coords_dest) {
+		recalc_slots.clear();
+		const double cutoff = params.Recalc_cutoff / lattice.getUnitSize() + 1e-6;
+		const double cutoff_squared = cutoff * cutoff;
+		for (int slot_index = 0; slot_index < (int)exciton_slots.size(); slot_index++) {
+			const auto& exciton_slot = exciton_slots[slot_index];
+			if (!exciton_slot.is_active) {
+				continue;
+			}
+			const Coords& coords = exciton_slot.exciton.getCoords();
+			if (!params.Enable_selective_recalc || calculateLatticeDistanceSquared(coords_initial, coords) <= cutoff_squared || calculateLatticeDistanceSquared(coords_dest, coords) <= cutoff_squared) {
+				recalc_slots.push_back(slot_index);
+			}
+		}
+	}
+
+	long int Exciton_sim::calculateLatticeDistanceSquared(const Coords& coords_start, const Coords& coords_end) const {
+		long int dx = abs(coords_end.x - coords_start.x);
+		long int dy = abs(coords_end.y - coords_start.y);
+		long int dz = abs(coords_end.z - coords_start.z);
+		if (lattice.isXPeriodic()) {
+			dx = min(dx, lattice.getLength() - dx);
+		}
+		if (lattice.isYPeriodic()) {
+			dy = min(dy, lattice.getWidth() - dy);
+		}
+		if (lattice.isZPeriodic()) {
+			dz = min(dz, lattice.getHeight() - dz);
+		}
+		return dx * dx + dy * dy + dz * dz;
 	}
 
 	// The function must be defined in the derived simulation class
 	bool Exciton_sim::checkFinished() const {
 		if (params.Enable_diffusion_test) {
-			return (N_excitons_recombined == params.N_tests);
+			return (N_excitons_recombined >= N_tests_target);
 		}
 		cout << "Error checking simulation finish conditions." << endl;
 		return true;
 	}
 
+	// The lattice and site energies only depend on the lattice parameters, the density of states model, and the site storage options
+	bool Exciton_sim::checkLatticeReusable(const Parameters& params_prev, const Parameters& params_new) {
+		const auto& lattice_prev = params_prev.Params_lattice;
+		const auto& lattice_new = params_new.Params_lattice;
+		return lattice_prev.Enable_periodic_x == lattice_new.Enable_periodic_x
+			&& lattice_prev.Enable_periodic_y == lattice_new.Enable_periodic_y
+			&& lattice_prev.Enable_periodic_z == lattice_new.Enable_periodic_z
+			&& lattice_prev.Length == lattice_new.Length
+			&& lattice_prev.Width == lattice_new.Width
+			&& lattice_prev.Height == lattice_new.Height
+			&& lattice_prev.Unit_size == lattice_new.Unit_size
+			&& params_prev.Enable_gaussian_dos == params_new.Enable_gaussian_dos
+			&& params_prev.Site_energy_stdev == params_new.Site_energy_stdev
+			&& params_prev.Enable_correlated_disorder == params_new.Enable_correlated_disorder
+			&& params_prev.Disorder_correlation_length == params_new.Disorder_correlation_length
+			&& params_prev.Enable_exponential_dos == params_new.Enable_exponential_dos
+			&& params_prev.Site_energy_urbach == params_new.Site_energy_urbach
+			&& params_prev.Enable_compact_sites == params_new.Enable_compact_sites
+			&& params_prev.Enable_sparse_sites == params_new.Enable_sparse_sites
+			&& params_prev.Random_seed == params_new.Random_seed;
+	}
+
 	void Exciton_sim::deleteExciton(Exciton* exciton_ptr) {
 		// Gather exciton information
-		auto exciton_it = getExcitonIt(exciton_ptr);
-		// Remove the Object and Event pointers from the Simulation base class using the removeObject function
-		removeObject(exciton_ptr);
-		// Locate corresponding recombination event
-		auto recombination_list_it = exciton_recombination_events.begin();
-		advance(recombination_list_it, std::distance(excitons.begin(), exciton_it));
-		// Locate corresponding hop event
-		auto hop_list_it = exciton_hop_events.begin();
-		advance(hop_list_it, std::distance(excitons.begin(), exciton_it));
-		// Delete exciton from the main list
-		excitons.erase(exciton_it);
-		// Delete exciton recombination event from the main list
-		exciton_recombination_events.erase(recombination_list_it);
-		// Delete exciton hop event from the main list
-		exciton_hop_events.erase(hop_list_it);
+		int slot_index = exciton_ptr->getSlotIndex();
+		// Update the empty site index
+		markSiteEmpty(lattice.getSiteIndex(exciton_ptr->getCoords()));
+		if (params.Enable_global_bkl) {
+			exciton_rates.setRate(slot_index, 0.0);
+		}
+		if (params.Enable_event_heap) {
+			event_schedule.remove(slot_index + 1);
+		}
+		// Release the slot holding the exciton and its events so that it can be reused by a new exciton
+		exciton_slots[slot_index].is_active = false;
+		free_slots.push_back(slot_index);
+	}
+
+	// The exciton keeps the same displacement from its previous hop until the current time
+	void Exciton_sim::updateDiffusionMsd(Exciton_slot& exciton_slot) {
+		const double time_created = exciton_slot.exciton.getCreationTime();
+		const double distance = lattice.getUnitSize()*exciton_slot.exciton.calculateDisplacement();
+		diffusion_msd.addInterval(exciton_slot.time_displaced - time_created, getTime() - time_created, distance*distance);
+		exciton_slot.time_displaced = getTime();
 	}
 
 	// Each event type should have an associated execute function
-	bool Exciton_sim::executeExcitonCreation(const list<Event*>::const_iterator event_it) {
+	bool Exciton_sim::executeExcitonCreation(Event* event_ptr) {
 		// Determine coordinates for the new exciton
 		Coords coords_new = calculateExcitonCreationCoords();
-		// Create the new exciton and add it to the simulation
-		Exciton exciton_new(getTime(), N_excitons_created + 1, coords_new);
-		excitons.push_back(exciton_new);
-		// Add new exciton to the Simulation base class using its addObject function
-		addObject(&excitons.back());
-		// Add an empty hop event to the main event list
-		Exciton::Hop hop_event(this);
-		exciton_hop_events.push_back(hop_event);
-		// Add the recombination event to the main event list
-		Exciton::Recombination recombination_event(this);
+		// Create the new exciton in an unused slot and add it to the simulation
+		int slot_index = allocateExcitonSlot();
+		auto& exciton_slot = exciton_slots[slot_index];
+		exciton_slot.exciton = Exciton(getTime(), N_excitons_created + 1, coords_new);
+		exciton_slot.exciton.setSlotIndex(slot_index);
+		exciton_slot.time_displaced = getTime();
+		// The exciton is only stored in the slot pool, so the site occupancy is set directly
+		markSiteOccupied(lattice.getSiteIndex(coords_new));
+		// Reset the hop event in the slot to an empty hop event
+		exciton_slot.hop_event = Exciton::Hop(this);
 		// Set the recombination event associated object using the Event class setObjectPtr function
-		recombination_event.setObjectPtr(&excitons.back());
+		exciton_slot.recombination_event.setObjectPtr(&exciton_slot.exciton);
 		// Since the rate constant for all recombination events is the same and does not change,
 		// it can be set during initialization using the Event class calculateRateConstant function
-		recombination_event.calculateRateConstant(1.0 / params.Exciton_lifetime);
-		exciton_recombination_events.push_back(recombination_event);
+		exciton_slot.recombination_event.calculateRateConstant(1.0 / params.Exciton_lifetime);
 		// Update counters
 		N_excitons_created++;
 		N_excitons++;
-		// Find all nearby excitons using the Simulation class findRecalcObjects function and calculate their next events
-		auto neighbors = findRecalcObjects(coords_new, coords_new);
-		for (auto& item : neighbors) {
-			calculateExcitonEvents(static_cast<Exciton*>(item));
-		}
+		logEvent(Exciton::Event_code::Creation, exciton_slot.exciton.getTag(), coords_new, coords_new);
+		// Find all nearby excitons and calculate their next events
+		recalculateNeighborEvents(coords_new, coords_new);
 		// Calculate when the next exciton creation event will occur
-		exciton_creation_event.calculateExecutionTime(R_exciton_generation);
+		calculateExecutionTime(exciton_creation_event, R_exciton_generation, rng_creation);
+		if (params.Enable_event_heap) {
+			event_schedule.update(0, exciton_creation_event.getExecutionTime());
+		}
 		return true;
 	}
 
 	// Each event type should have an associated execute function
-	bool Exciton_sim::executeExcitonHop(const list<Event*>::const_iterator event_it) {
+	bool Exciton_sim::executeExcitonHop(Event* event_ptr) {
 		// Check to make sure that the destination site is still unoccupied
 		// This error can occur when using the selective recalculation KMC algorithm if the recalculation cutoff radius is not set correctly
-		if (lattice.isOccupied((*event_it)->getDestCoords())) {
+		if (isSiteOccupied(event_ptr->getDestCoords())) {
 			cout << "Error! Exciton hop cannot be executed. Destination site is already occupied." << endl;
 			return false;
 		}
 		else {
 			// Get event and object info
-			Coords coords_initial = ((*event_it)->getObjectPtr())->getCoords();
-			Coords coords_dest = (*event_it)->getDestCoords();
-			Object* exciton_ptr = (*event_it)->getObjectPtr();
-			// Move the exciton using the Simulation base class moveObject function
-			moveObject(exciton_ptr, coords_dest);
-			// Find all nearby excitons using the Simulation class findRecalcObjects function and calculate their next events
-			auto neighbors = findRecalcObjects(coords_initial, coords_dest);
-			for (auto& item : neighbors) {
-				calculateExcitonEvents(static_cast<Exciton*>(item));
+			Coords coords_initial = (event_ptr->getObjectPtr())->getCoords();
+			Coords coords_dest = event_ptr->getDestCoords();
+			Object* exciton_ptr = event_ptr->getObjectPtr();
+			if (params.Enable_diffusion_test) {
+				updateDiffusionMsd(exciton_slots[static_cast<Exciton*>(exciton_ptr)->getSlotIndex()]);
 			}
+			// Move the exciton and count the periodic boundary crossings in the same way as the Simulation base class
+			// moveObject function, which is not used because the excitons are not stored in the object list of the base class
+			exciton_ptr->incrementDX(lattice.calculateDX(coords_initial, coords_dest));
+			exciton_ptr->incrementDY(lattice.calculateDY(coords_initial, coords_dest));
+			exciton_ptr->incrementDZ(lattice.calculateDZ(coords_initial, coords_dest));
+			exciton_ptr->setCoords(coords_dest);
+			markSiteEmpty(lattice.getSiteIndex(coords_initial));
+			markSiteOccupied(lattice.getSiteIndex(coords_dest));
+			logEvent(Exciton::Event_code::Hop, exciton_ptr->getTag(), coords_initial, coords_dest);
+			// Find all nearby excitons and calculate their next events
+			recalculateNeighborEvents(coords_initial, coords_dest);
 			return true;
 		}
 	}
 
 	// Each event type should have an associated execute function
-	bool Exciton_sim::executeExcitonRecombination(const list<Event*>::const_iterator event_it) {
+	bool Exciton_sim::executeExcitonRecombination(Event* event_ptr) {
 		// Get event info
-		int exciton_tag = ((*event_it)->getObjectPtr())->getTag();
-		Coords coords_initial = ((*event_it)->getObjectPtr())->getCoords();
+		int exciton_tag = (event_ptr->getObjectPtr())->getTag();
+		Coords coords_initial = (event_ptr->getObjectPtr())->getCoords();
 		// Output final diffusion displacement distance in nm
 		if (params.Enable_diffusion_test) {
-			diffusion_distances.push_back(lattice.getUnitSize()*((*event_it)->getObjectPtr())->calculateDisplacement());
+			double distance = lattice.getUnitSize()*(event_ptr->getObjectPtr())->calculateDisplacement();
+			diffusion_stats.addValue(distance);
+			diffusion_histogram.addValue(distance);
+			diffusion_sample.addValue(distance);
+			updateDiffusionMsd(exciton_slots[static_cast<Exciton*>(event_ptr->getObjectPtr())->getSlotIndex()]);
 		}
 		// Delete Exciton and its events
-		deleteExciton(static_cast<Exciton*>((*event_it)->getObjectPtr()));
+		deleteExciton(static_cast<Exciton*>(event_ptr->getObjectPtr()));
 		// Update exciton counters
 		N_excitons--;
 		N_excitons_recombined++;
-		// Find all nearby excitons using the Simulation class findRecalcObjects function and calculate their next events
-		auto neighbors = findRecalcObjects(coords_initial, coords_initial);
-		for (auto& item : neighbors) {
-			calculateExcitonEvents(static_cast<Exciton*>(item));
-		}
+		logEvent(Exciton::Event_code::Recombination, exciton_tag, coords_initial, coords_initial);
+		// Find all nearby excitons and calculate their next events
+		recalculateNeighborEvents(coords_initial, coords_initial);
 		return true;
 	}
 
 	bool Exciton_sim::executeNextEvent() {
-		// Use the Simulation class chooseNextEvent function to determine which event will be executed
-		auto event_it = chooseNextEvent();
-		// Gather event info
-		string event_name = (*event_it)->getEventType();
-		// Update simulation time
-		setTime((*event_it)->getExecutionTime());
-		// Determine which event type has been chosen and run the appropriate execute function
-		if (event_name.compare(Exciton::Creation::event_type) == 0) {
-			return executeExcitonCreation(event_it);
+		// The global BKL engine chooses the next event from the rate tree and advances the simulation time itself
+		Event* event_ptr;
+		if (params.Enable_global_bkl) {
+			event_ptr = chooseNextEventGlobal();
+		}
+		// The event heap scheduler takes the event with the earliest execution time from the top of the heap
+		else if (params.Enable_event_heap) {
+			const int handle = event_schedule.getNextHandle();
+			if (handle == 0) {
+				event_ptr = &exciton_creation_event;
+			}
+			else {
+				auto& exciton_slot = exciton_slots[handle - 1];
+				event_ptr = (exciton_slot.selected_event_code == Exciton::Event_code::Hop) ? (Event*)&exciton_slot.hop_event : (Event*)&exciton_slot.recombination_event;
+			}
+			setTime(event_ptr->getExecutionTime());
+			N_events_executed_direct++;
 		}
-		else if (event_name.compare(Exciton::Hop::event_type) == 0) {
-			return executeExcitonHop(event_it);
+		// Otherwise, check the selected events of all excitons to determine which event will be executed
+		else {
+			event_ptr = chooseNextEventScan();
+			// Update simulation time
+			setTime(event_ptr->getExecutionTime());
+			N_events_executed_direct++;
+		}
+		// Determine which event type has been chosen and run the appropriate execute function
+		// All events in this simulation are exciton events, so the event code can be used instead of the event type string
+		// When profiling is enabled, the execution time of each event includes the recalculation of the neighboring exciton events
+		PROFILE(auto profile_time = Profiler::now());
+		bool success;
+		switch (static_cast<const Exciton::Coded_event*>(event_ptr)->getEventCode()) {
+		case Exciton::Event_code::Creation:
+			success = executeExcitonCreation(event_ptr);
+			PROFILE(profiler.lap(Profile_timer::Creation_event, profile_time));
+			return success;
+		case Exciton::Event_code::Hop:
+			success = executeExcitonHop(event_ptr);
+			PROFILE(profiler.lap(Profile_timer::Hop_event, profile_time));
+			return success;
+		case Exciton::Event_code::Recombination:
+			success = executeExcitonRecombination(event_ptr);
+			PROFILE(profiler.lap(Profile_timer::Recombination_event, profile_time));
+			return success;
 		}
-		else if (event_name.compare(Exciton::Recombination::event_type) == 0) {
-			return executeExcitonRecombination(event_it);
+		//error
+		cout << "Error! Valid event not found when calling executeNextEvent." << endl;
+		return false;
+	}
+
+	// Simple utility function for getting an unused slot from the exciton pool
+	int Exciton_sim::allocateExcitonSlot() {
+		int slot_index;
+		// Recycle a released slot if one is available, otherwise grow the pool
+		if (!free_slots.empty()) {
+			slot_index = free_slots.back();
+			free_slots.pop_back();
 		}
 		else {
-			//error
-			cout << "Error! Valid event not found when calling executeNextEvent." << endl;
+			exciton_slots.emplace_back(this);
+			slot_index = (int)exciton_slots.size() - 1;
+		}
+		exciton_slots[slot_index].is_active = true;
+		return slot_index;
+	}
+
+	// The histogram has 1000 bins that are each one tenth of the lattice unit size wide
+	Histogram Exciton_sim::createDiffusionHistogram(const Parameters& params) {
+		return Histogram(0.1*params.Params_lattice.Unit_size, 1000);
+	}
+
+	// The time bins cover from one millionth to one hundred times the exciton lifetime with ten bins per decade
+	Time_binned_msd Exciton_sim::createDiffusionMsd(const Parameters& params) {
+		return Time_binned_msd(1e-6*params.Exciton_lifetime, 100.0*params.Exciton_lifetime, 10);
+	}
+
+	void Exciton_sim::enableDiffusionSample(const int sample_size) {
+		diffusion_sample = Reservoir_sample(sample_size, (unsigned long int)getId());
+	}
+
+	bool Exciton_sim::enableEventLog(const string& filename, const bool Enable_compression) {
+		if (!event_log.open(filename, Enable_compression)) {
+			cout << getId() << ": Error! Event log file " << filename << " could not be created." << endl;
 			return false;
 		}
+		return true;
 	}
 
-	// Simple utility function for converting from object pointer to object list iterator
-	list<Exciton>::iterator Exciton_sim::getExcitonIt(const Exciton* exciton_ptr) {
-		auto it = find_if(excitons.begin(), excitons.end(), [exciton_ptr](Exciton& a) {return (a.getTag() == exciton_ptr->getTag()); });
-		if (it == excitons.end()) {
-			cout << "Error! Exciton iterator could not be located." << endl;
+	bool Exciton_sim::closeEventLog() {
+		if (!event_log.close()) {
+			cout << getId() << ": Error! The event log could not be written completely." << endl;
+			return false;
 		}
-		return it;
+		return true;
+	}
+
+	const Histogram& Exciton_sim::getDiffusionHistogram() const {
+		return diffusion_histogram;
+	}
+
+	const Time_binned_msd& Exciton_sim::getDiffusionMsd() const {
+		return diffusion_msd;
+	}
+
+	const Reservoir_sample& Exciton_sim::getDiffusionSample() const {
+		return diffusion_sample;
+	}
+
+	const Running_stats& Exciton_sim::getDiffusionStats() const {
+		return diffusion_stats;
 	}
 
-	vector<double> Exciton_sim::getDiffusionData() {
-		return diffusion_distances;
+	long int Exciton_sim::getN_events_executed() const {
+		return N_events_executed_direct + N_events_executed_restored;
 	}
 
 	int Exciton_sim::getN_excitons_created() {
@@ -317,19 +814,749 @@ namespace KMC_Lattice_example {
 		return N_excitons_recombined;
 	}
 
+	int Exciton_sim::getN_tests_target() const {
+		return N_tests_target;
+	}
+
+	const Profiler& Exciton_sim::getProfiler() const {
+		return profiler;
+	}
+
+	void Exciton_sim::setN_tests_target(const int N_tests) {
+		N_tests_target = N_tests;
+	}
+
+	bool Exciton_sim::loadCheckpoint(const string& filename) {
+		ifstream file(filename, ifstream::binary);
+		if (!file) {
+			cout << getId() << ": Error! Checkpoint file " << filename << " could not be opened." << endl;
+			return false;
+		}
+		if (N_excitons_created != 0) {
+			cout << getId() << ": Error! A checkpoint can only be loaded into a newly constructed simulation." << endl;
+			return false;
+		}
+		// Check that the checkpoint file matches this simulation
+		char magic[sizeof(checkpoint_magic)];
+		int version = 0;
+		int id = -1;
+		int length = 0, width = 0, height = 0;
+		int stencil_size = 0;
+		bool compact_sites = false;
+		bool sparse_sites = false;
+		uint64_t seed = 0;
+		bool landscape = false;
+		bool global_bkl = false;
+		file.read(magic, sizeof(checkpoint_magic));
+		if (!file.good() || !equal(magic, magic + sizeof(checkpoint_magic), checkpoint_magic)) {
+			cout << getId() << ": Error! " << filename << " is not a valid checkpoint file." << endl;
+			return false;
+		}
+		if (!readBinary(file, version) || version != checkpoint_version) {
+			cout << getId() << ": Error! Checkpoint file version " << version << " is not supported." << endl;
+			return false;
+		}
+		readBinary(file, id);
+		readBinary(file, length);
+		readBinary(file, width);
+		readBinary(file, height);
+		readBinary(file, stencil_size);
+		readBinary(file, compact_sites);
+		readBinary(file, sparse_sites);
+		readBinary(file, seed);
+		readBinary(file, landscape);
+		readBinary(file, global_bkl);
+		if (!file.good() || id != getId() || length != lattice.getLength() || width != lattice.getWidth() || height != lattice.getHeight() || stencil_size != (int)hop_stencil.size() || compact_sites != params.Enable_compact_sites || sparse_sites != params.Enable_sparse_sites || (params.Enable_sparse_sites && seed != random_seed) || landscape != (landscape_ptr != nullptr) || global_bkl != params.Enable_global_bkl) {
+			cout << getId() << ": Error! Checkpoint file " << filename << " was created by a different simulation." << endl;
+			return false;
+		}
+		// Simulation state and counters
+		double time = 0.0;
+		long int N_events = 0;
+		readBinary(file, time);
+		readBinary(file, N_events);
+		readBinary(file, N_excitons);
+		readBinary(file, N_excitons_created);
+		readBinary(file, N_excitons_recombined);
+		readBinary(file, N_tests_target);
+		uint64_t position_creation = 0, position_events = 0;
+		readBinary(file, position_creation);
+		readBinary(file, position_events);
+		// Site energies and the empty site index
+		// The site energies are read one at a time so that no temporary copy of the whole lattice is needed
+		// No site energies are stored in the sparse site storage mode or when an energy landscape is used
+		long int N_sites = 0;
+		readBinary(file, N_sites);
+		if (!file.good() || N_sites != ((params.Enable_sparse_sites || landscape_ptr != nullptr) ? 0 : lattice.getNumSites())) {
+			cout << getId() << ": Error! Lattice data in checkpoint file " << filename << " could not be read." << endl;
+			return false;
+		}
+		for (long int i = 0; i < N_sites; i++) {
+			double energy = 0.0;
+			readBinary(file, energy);
+			setSiteEnergy(i, energy);
+		}
+		readBinaryVector(file, empty_site_indices);
+		if (!file.good() || (long int)empty_site_indices.size() > lattice.getNumSites()) {
+			cout << getId() << ": Error! Lattice data in checkpoint file " << filename << " could not be read." << endl;
+			return false;
+		}
+		calculateBoltzmannWeights();
+		if (!params.Enable_compact_sites && !params.Enable_sparse_sites) {
+			empty_site_positions.assign(lattice.getNumSites(), -1);
+			for (long int i = 0; i < (long int)empty_site_indices.size(); i++) {
+				empty_site_positions[empty_site_indices[i]] = i;
+			}
+		}
+		// Exciton creation event
+		double creation_time = 0.0;
+		readBinary(file, creation_time);
+		exciton_creation_event.setExecutionTime(creation_time);
+		// Exciton slot pool
+		int N_slots = 0;
+		readBinary(file, N_slots);
+		readBinaryVector(file, free_slots);
+		if (!file.good() || N_slots < 0 || (int)free_slots.size() > N_slots) {
+			cout << getId() << ": Error! Exciton data in checkpoint file " << filename << " could not be read." << endl;
+			return false;
+		}
+		while ((int)exciton_slots.size() < N_slots) {
+			exciton_slots.emplace_back(this);
+		}
+		for (int slot_index : free_slots) {
+			if (slot_index < 0 || slot_index >= N_slots || exciton_slots[slot_index].is_active) {
+				cout << getId() << ": Error! Exciton data in checkpoint file " << filename << " could not be read." << endl;
+				return false;
+			}
+			// Free slots are marked active until all excitons are restored to detect slots that are used twice
+			exciton_slots[slot_index].is_active = true;
+		}
+		// Excitons, their selected events, and their hop rate tables
+		// Each exciton is restored into its original slot
+		auto readCoords = [&file](Coords& coords) {
+			readBinary(file, coords.x);
+			readBinary(file, coords.y);
+			readBinary(file, coords.z);
+		};
+		int N_active = 0;
+		readBinary(file, N_active);
+		if (!file.good() || N_active != N_slots - (int)free_slots.size()) {
+			cout << getId() << ": Error! Exciton data in checkpoint file " << filename << " could not be read." << endl;
+			return false;
+		}
+		for (int i = 0; i < N_active && file.good(); i++) {
+			int slot_index = -1;
+			int tag = 0;
+			double time_created = 0.0;
+			Coords coords_created, coords_current, coords_dest;
+			int dx = 0, dy = 0, dz = 0;
+			int event_code = 0;
+			double recombination_rate = 0.0, recombination_time = 0.0, hop_rate = 0.0, hop_time = 0.0;
+			double time_displaced = 0.0;
+			readBinary(file, slot_index);
+			readBinary(file, tag);
+			readBinary(file, time_created);
+			readBinary(file, time_displaced);
+			readCoords(coords_created);
+			readCoords(coords_current);
+			readBinary(file, dx);
+			readBinary(file, dy);
+			readBinary(file, dz);
+			readBinary(file, event_code);
+			readBinary(file, recombination_rate);
+			readBinary(file, recombination_time);
+			readCoords(coords_dest);
+			readBinary(file, hop_rate);
+			readBinary(file, hop_time);
+			if (!file.good() || slot_index < 0 || slot_index >= N_slots || exciton_slots[slot_index].is_active) {
+				cout << getId() << ": Error! Exciton data in checkpoint file " << filename << " could not be read." << endl;
+				return false;
+			}
+			auto& exciton_slot = exciton_slots[slot_index];
+			exciton_slot.is_active = true;
+			readBinaryVector(file, exciton_slot.hop_weights);
+			readBinary(file, exciton_slot.weight_origin_inv);
+			if (!exciton_slot.hop_rates.readBinary(file) || !readBinary(file, exciton_slot.hop_rate_total) || (int)exciton_slot.hop_weights.size() != stencil_size) {
+				cout << getId() << ": Error! Exciton data in checkpoint file " << filename << " could not be read." << endl;
+				return false;
+			}
+			exciton_slot.exciton = Exciton(time_created, tag, coords_created);
+			exciton_slot.exciton.setSlotIndex(slot_index);
+			exciton_slot.time_displaced = time_displaced;
+			exciton_slot.exciton.setCoords(coords_current);
+			exciton_slot.exciton.incrementDX(dx);
+			exciton_slot.exciton.incrementDY(dy);
+			exciton_slot.exciton.incrementDZ(dz);
+			markSiteOccupied(lattice.getSiteIndex(coords_current));
+			exciton_slot.recombination_event.setObjectPtr(&exciton_slot.exciton);
+			exciton_slot.recombination_event.calculateRateConstant(recombination_rate);
+			exciton_slot.recombination_event.setExecutionTime(recombination_time);
+			exciton_slot.hop_event = Exciton::Hop(this);
+			exciton_slot.hop_event.setObjectPtr(&exciton_slot.exciton);
+			exciton_slot.hop_event.setDestCoords(coords_dest);
+			exciton_slot.hop_event.Event::calculateRateConstant(hop_rate);
+			exciton_slot.hop_event.setExecutionTime(hop_time);
+			exciton_slot.selected_event_code = (event_code == (int)Exciton::Event_code::Hop) ? Exciton::Event_code::Hop : Exciton::Event_code::Recombination;
+		}
+		for (int slot_index : free_slots) {
+			exciton_slots[slot_index].is_active = false;
+		}
+		if (!exciton_rates.readBinary(file)) {
+			cout << getId() << ": Error! Exciton data in checkpoint file " << filename << " could not be read." << endl;
+			return false;
+		}
+		// Diffusion test data
+		diffusion_stats.readBinary(file);
+		diffusion_histogram.readBinary(file);
+		diffusion_sample.readBinary(file);
+		diffusion_msd.readBinary(file);
+		if (!file.good()) {
+			cout << getId() << ": Error! Checkpoint file " << filename << " is incomplete." << endl;
+			return false;
+		}
+		// The event heap scheduler needs the execution time of the selected event of each exciton
+		for (int slot_index = 0; slot_index < (int)exciton_slots.size(); slot_index++) {
+			auto& exciton_slot = exciton_slots[slot_index];
+			if (exciton_slot.is_active) {
+				if (params.Enable_event_heap) {
+					const Event& event = (exciton_slot.selected_event_code == Exciton::Event_code::Hop) ? (const Event&)exciton_slot.hop_event : (const Event&)exciton_slot.recombination_event;
+					event_schedule.update(slot_index + 1, event.getExecutionTime());
+				}
+			}
+		}
+		if (params.Enable_event_heap) {
+			event_schedule.update(0, exciton_creation_event.getExecutionTime());
+		}
+		// Restore the simulation time, event counter, and random number streams last
+		// The site energies were read from the checkpoint unless they are calculated from the seed, which then already matches.
+		setTime(time);
+		N_events_executed_restored = N_events - N_events_executed_direct;
+		random_seed = seed;
+		rng_site_energies = Random_stream(random_seed, (unsigned int)getId(), (unsigned int)Random_purpose::Site_energies);
+		seedEventStreams(random_seed);
+		rng_creation.setPosition(position_creation);
+		rng_events.setPosition(position_events);
+		return true;
+	}
+
+	// The site storage is one occupancy bit per site with an energy landscape, one occupancy bit, a float energy, and a double
+	// weight per site in the compact site storage mode, and one Site_OSC object per site otherwise.  The empty site index and
+	// its position table are allocated after the site energies are created, unless the compact or sparse site storage mode is
+	// used, so the peak is the site storage plus the larger of the empty site index and the temporary correlated energy arrays.
+	double Exciton_sim::predictMemoryUsage(const Parameters& params, const bool Enable_landscape) {
+		double N_sites = (double)params.Params_lattice.Length*params.Params_lattice.Width*params.Params_lattice.Height;
+		// No site properties are stored in the sparse site storage mode
+		if (params.Enable_sparse_sites) {
+			return 0.0;
+		}
+		double bytes_per_site = 0.0;
+		if (Enable_landscape) {
+			bytes_per_site += 1.0 / 8.0;
+		}
+		else if (params.Enable_compact_sites) {
+			bytes_per_site += 1.0 / 8.0 + sizeof(float) + sizeof(double);
+		}
+		else {
+			bytes_per_site += sizeof(Site_OSC);
+		}
+		// Correlated site energies need a complex Fourier transform array and an output vector during creation
+		double bytes_per_site_temp = 0.0;
+		if (params.Enable_correlated_disorder && !Enable_landscape) {
+			bytes_per_site_temp = sizeof(complex<double>) + sizeof(double);
+		}
+		if (!params.Enable_compact_sites) {
+			bytes_per_site_temp = max(bytes_per_site_temp, 2.0 * sizeof(long int));
+		}
+		return N_sites * (bytes_per_site + bytes_per_site_temp);
+	}
+
+	bool Exciton_sim::reconfigure(const Parameters& params_new) {
+		if (!params_new.checkParameters() || !checkLatticeReusable(params, params_new)) {
+			return false;
+		}
+		// Remove all excitons
+		for (auto& exciton_slot : exciton_slots) {
+			if (exciton_slot.is_active) {
+				deleteExciton(&exciton_slot.exciton);
+			}
+		}
+		// Reinitialize the Simulation base class with the new parameters and move the exciton creation and exciton event
+		// streams back to their start
+		params = params_new;
+		init(params, getId());
+		seedEventStreams(random_seed);
+		setTime(0.0);
+		N_events_executed_restored = 0;
+		N_events_executed_direct = 0;
+		exciton_rates.clear();
+		event_schedule.clear();
+		// Reset the counters and test data
+		N_excitons = 0;
+		N_excitons_created = 0;
+		N_excitons_recombined = 0;
+		N_tests_target = params.N_tests;
+		diffusion_stats = Running_stats();
+		diffusion_sample = Reservoir_sample(diffusion_sample.getCapacity(), (unsigned long int)getId());
+		profiler = Profiler();
+		// Recalculate the temperature-dependent site data and rebuild the lattice data and events
+		calculateBoltzmannWeights();
+		initializeEmptySiteIndex();
+		initializeEvents();
+		return true;
+	}
+
+	void Exciton_sim::runIndependentWalkers(const int N_walkers, const int N_threads) {
+		// Each walker uses its own part of the independent walker stream, which starts at the walker number times 2^32, so that
+		// the displacement of each walker does not depend on the number of threads.  Each thread uses its own statistics
+		// accumulators, and the random sample of each thread is seeded from the exciton event stream.
+		vector<uint64_t> seeds(N_threads);
+		for (auto& item : seeds) {
+			item = rng_events();
+		}
+		vector<Running_stats> stats_threads(N_threads);
+		vector<Histogram> histograms_threads(N_threads, createDiffusionHistogram(params));
+		vector<Reservoir_sample> samples_threads;
+		for (int i = 0; i < N_threads; i++) {
+			samples_threads.push_back(Reservoir_sample(diffusion_sample.getCapacity(), seeds[i]));
+		}
+		auto runWalkers = [&](const int thread_num) {
+			int walker_first = thread_num * (N_walkers / N_threads) + min(thread_num, N_walkers % N_threads);
+			int N_walkers_thread = N_walkers / N_threads + (thread_num < N_walkers % N_threads ? 1 : 0);
+			Random_stream walker_stream(random_seed, (unsigned int)getId(), (unsigned int)Random_purpose::Independent_walkers);
+			vector<double> prefactors(hop_stencil.size());
+			vector<double> weights(hop_stencil.size());
+			vector<double> rates_cumulative(hop_stencil.size());
+			for (int i = 0; i < N_walkers_thread; i++) {
+				walker_stream.setPosition((uint64_t)(N_excitons_created + walker_first + i) << 32);
+				double distance = simulateIndependentWalker(walker_stream, prefactors, weights, rates_cumulative);
+				stats_threads[thread_num].addValue(distance);
+				histograms_threads[thread_num].addValue(distance);
+				samples_threads[thread_num].addValue(distance);
+			}
+		};
+		if (N_threads == 1) {
+			runWalkers(0);
+		}
+		else {
+			vector<thread> threads;
+			for (int i = 0; i < N_threads; i++) {
+				threads.emplace_back(runWalkers, i);
+			}
+			for (auto& item : threads) {
+				item.join();
+			}
+		}
+		for (int i = 0; i < N_threads; i++) {
+			diffusion_stats.merge(stats_threads[i]);
+			diffusion_histogram.merge(histograms_threads[i]);
+			diffusion_sample.merge(samples_threads[i]);
+		}
+		N_excitons_created += N_walkers;
+		N_excitons_recombined += N_walkers;
+		// The walkers are only independent if an exciton is unlikely to come within the FRET cutoff radius of another
+		// exciton during its lifetime.  Estimate the number of other excitons within the diffusion length plus the FRET
+		// cutoff radius using the steady state exciton density.
+		double exciton_density = params.Exciton_generation_rate * params.Exciton_lifetime; // (cm^-3)
+		double interaction_radius = 1e-7*(diffusion_stats.getMean() + params.FRET_cutoff); // (cm)
+		double N_excitons_nearby = exciton_density * (4.0 / 3.0)*Pi*intpow(interaction_radius, 3);
+		if (N_excitons_nearby > 0.1) {
+			cout << getId() << ": Warning! The steady state exciton density of " << exciton_density << " cm^-3 results in an average of " << N_excitons_nearby << " other excitons within the diffusion length plus the FRET cutoff radius, so the independent walker approximation is not valid." << endl;
+		}
+	}
+
 	void Exciton_sim::outputStatus() const {
 		cout << getId() << ": Time = " << getTime() << " seconds.\n";
 		cout << getId() << ": " << N_excitons_created << " excitons have been created and " << getN_events_executed() << " events have been executed.\n";
 		cout << getId() << ": There are " << N_excitons << " excitons in the lattice.\n";
-		for (auto& item : excitons) {
-			cout << getId() << ": Exciton " << item.getTag() << " is at " << item.getCoords().x << "," << item.getCoords().y << "," << item.getCoords().z << ".\n";
+		for (auto& item : exciton_slots) {
+			if (!item.is_active) {
+				continue;
+			}
+			cout << getId() << ": Exciton " << item.exciton.getTag() << " is at " << item.exciton.getCoords().x << "," << item.exciton.getCoords().y << "," << item.exciton.getCoords().z << ".\n";
 		}
 		cout.flush();
 	}
 
+	bool Exciton_sim::saveCheckpoint(const string& filename) const {
+		const string filename_temp = filename + ".tmp";
+		ofstream file(filename_temp, ofstream::binary | ofstream::trunc);
+		if (!file) {
+			cout << getId() << ": Error! Checkpoint file " << filename_temp << " could not be opened." << endl;
+			return false;
+		}
+		// Header used to check that the checkpoint file matches the simulation when it is loaded
+		file.write(checkpoint_magic, sizeof(checkpoint_magic));
+		writeBinary(file, checkpoint_version);
+		writeBinary(file, getId());
+		writeBinary(file, (int)lattice.getLength());
+		writeBinary(file, (int)lattice.getWidth());
+		writeBinary(file, (int)lattice.getHeight());
+		writeBinary(file, (int)hop_stencil.size());
+		writeBinary(file, params.Enable_compact_sites);
+		writeBinary(file, params.Enable_sparse_sites);
+		writeBinary(file, random_seed);
+		writeBinary(file, landscape_ptr != nullptr);
+		writeBinary(file, params.Enable_global_bkl);
+		// Simulation state and counters
+		writeBinary(file, getTime());
+		writeBinary(file, getN_events_executed());
+		writeBinary(file, N_excitons);
+		writeBinary(file, N_excitons_created);
+		writeBinary(file, N_excitons_recombined);
+		writeBinary(file, N_tests_target);
+		writeBinary(file, rng_creation.getPosition());
+		writeBinary(file, rng_events.getPosition());
+		// Site energies and the empty site index, whose order determines where new excitons are created
+		// The site energies are written one at a time so that no temporary copy of the whole lattice is needed
+		// No site energies are stored in the sparse site storage mode or when an energy landscape is used
+		const long int N_sites = (params.Enable_sparse_sites || landscape_ptr != nullptr) ? 0 : lattice.getNumSites();
+		writeBinary(file, N_sites);
+		for (long int i = 0; i < N_sites; i++) {
+			writeBinary(file, getSiteEnergy(i));
+		}
+		writeBinaryVector(file, empty_site_indices);
+		// Exciton creation event
+		writeBinary(file, exciton_creation_event.getExecutionTime());
+		// Exciton slot pool
+		// The excitons to recalculate are visited in slot order and ties between events go to the lowest slot, so the slot of
+		// each exciton and the order in which free slots are reused must be restored for the run to continue identically
+		writeBinary(file, (int)exciton_slots.size());
+		writeBinaryVector(file, free_slots);
+		// Excitons, their selected events, and their hop rate tables in slot order
+		// The hop rate tables are saved instead of recalculated, because the totals and selections of their Fenwick trees
+		// depend on the order of the previous rate updates in their last bits
+		vector<int> active_slots;
+		for (int slot_index = 0; slot_index < (int)exciton_slots.size(); slot_index++) {
+			if (exciton_slots[slot_index].is_active) {
+				active_slots.push_back(slot_index);
+			}
+		}
+		auto writeCoords = [&file](const Coords& coords) {
+			writeBinary(file, coords.x);
+			writeBinary(file, coords.y);
+			writeBinary(file, coords.z);
+		};
+		writeBinary(file, (int)active_slots.size());
+		for (int slot_index : active_slots) {
+			auto item = &exciton_slots[slot_index];
+			writeBinary(file, slot_index);
+			writeBinary(file, (int)item->exciton.getTag());
+			writeBinary(file, item->exciton.getCreationTime());
+			writeBinary(file, item->time_displaced);
+			writeCoords(item->exciton.getCreationCoords());
+			writeCoords(item->exciton.getCoords());
+			writeBinary(file, (int)item->exciton.getDX());
+			writeBinary(file, (int)item->exciton.getDY());
+			writeBinary(file, (int)item->exciton.getDZ());
+			writeBinary(file, (int)item->selected_event_code);
+			writeBinary(file, item->recombination_event.getRateConstant());
+			writeBinary(file, item->recombination_event.getExecutionTime());
+			writeCoords(item->hop_event.getDestCoords());
+			writeBinary(file, item->hop_event.getRateConstant());
+			writeBinary(file, item->hop_event.getExecutionTime());
+			writeBinaryVector(file, item->hop_weights);
+			writeBinary(file, item->weight_origin_inv);
+			item->hop_rates.writeBinary(file);
+			writeBinary(file, item->hop_rate_total);
+		}
+		// Total event rates of the excitons for the global BKL engine
+		exciton_rates.writeBinary(file);
+		// Diffusion test data
+		diffusion_stats.writeBinary(file);
+		diffusion_histogram.writeBinary(file);
+		diffusion_sample.writeBinary(file);
+		diffusion_msd.writeBinary(file);
+		file.close();
+		if (file.fail()) {
+			cout << getId() << ": Error! Checkpoint file " << filename_temp << " could not be written." << endl;
+			return false;
+		}
+		// Replace the previous checkpoint file
+		if (rename(filename_temp.c_str(), filename.c_str()) != 0) {
+			cout << getId() << ": Error! Checkpoint file " << filename_temp << " could not be renamed to " << filename << "." << endl;
+			return false;
+		}
+		return true;
+	}
+
+	// The site is removed from the empty site index by moving the last entry into its position
+	// The event codes in the log are the values of the Exciton::Event_code enum
+	void Exciton_sim::logEvent(const Exciton::Event_code event_code, const int tag, const Coords& coords_initial, const Coords& coords_dest) {
+		if (!event_log.isOpen()) {
+			return;
+		}
+		event_log.addRecord({ getTime(), (int)event_code, tag, coords_initial.x, coords_initial.y, coords_initial.z, coords_dest.x, coords_dest.y, coords_dest.z });
+	}
+
+	void Exciton_sim::markSiteOccupied(const long int site_index) {
+		if (params.Enable_sparse_sites) {
+			occupied_sites.insert(site_index);
+			return;
+		}
+		if (params.Enable_compact_sites || landscape_ptr != nullptr) {
+			site_occupancy_compact[site_index] = true;
+		}
+		else {
+			sites[site_index].setOccupied();
+		}
+		if (params.Enable_compact_sites) {
+			return;
+		}
+		long int position = empty_site_positions[site_index];
+		if (position < 0) {
+			return;
+		}
+		long int last_index = empty_site_indices.back();
+		empty_site_indices[position] = last_index;
+		empty_site_positions[last_index] = position;
+		empty_site_indices.pop_back();
+		empty_site_positions[site_index] = -1;
+	}
+
+	// The site is added to the end of the empty site index
+	void Exciton_sim::markSiteEmpty(const long int site_index) {
+		if (params.Enable_sparse_sites) {
+			occupied_sites.erase(site_index);
+			return;
+		}
+		if (params.Enable_compact_sites || landscape_ptr != nullptr) {
+			site_occupancy_compact[site_index] = false;
+		}
+		else {
+			sites[site_index].clearOccupancy();
+		}
+		if (params.Enable_compact_sites || empty_site_positions[site_index] >= 0) {
+			return;
+		}
+		empty_site_positions[site_index] = (long int)empty_site_indices.size();
+		empty_site_indices.push_back(site_index);
+	}
+
+	// The empty site index needs two long integers per site, so it is not used with compact or sparse site storage
+	void Exciton_sim::initializeEmptySiteIndex() {
+		if (!params.Enable_compact_sites && !params.Enable_sparse_sites) {
+			empty_site_indices.resize(lattice.getNumSites());
+			empty_site_positions.resize(lattice.getNumSites());
+			for (long int i = 0; i < lattice.getNumSites(); i++) {
+				empty_site_indices[i] = i;
+				empty_site_positions[i] = i;
+			}
+		}
+	}
+
+	// All parameter-dependent event data is rebuilt, so this function is also used when the simulation is reconfigured
+	void Exciton_sim::initializeEvents() {
+		// Build the hop stencil from all lattice displacements within the FRET cutoff radius
+		// The exction hop range is calculated in lattice units based on the specified hop cutoff distance in real space units
+		int range = (int)ceil((double)params.FRET_cutoff / lattice.getUnitSize());
+		hop_stencil.clear();
+		for (int i = -range; i <= range; i++) {
+			for (int j = -range; j <= range; j++) {
+				for (int k = -range; k <= range; k++) {
+					if (i == 0 && j == 0 && k == 0) {
+						continue;
+					}
+					// Calculate the real space distance of the move in nm
+					double distance = lattice.getUnitSize()*sqrt((double)(i*i + j * j + k * k));
+					// Save the move only if the move distance is less than the specified cutoff distance
+					if ((distance - 0.0001) > params.FRET_cutoff) {
+						continue;
+					}
+					Hop_offset offset;
+					offset.dx = i;
+					offset.dy = j;
+					offset.dz = k;
+					offset.distance = distance;
+					offset.prefactor = params.R_exciton_hopping * intpow(1.0 / distance, 6);
+					hop_stencil.push_back(offset);
+				}
+			}
+		}
+		// Build the lookup table from each lattice displacement within the hop range to its hop_stencil entry
+		hop_range = range;
+		const int width = 2 * range + 1;
+		hop_stencil_lookup.assign(width*width*width, -1);
+		hop_prefactors.clear();
+		for (int n = 0; n < (int)hop_stencil.size(); n++) {
+			const Hop_offset& offset = hop_stencil[n];
+			hop_stencil_lookup[((offset.dx + range)*width + offset.dy + range)*width + offset.dz + range] = n;
+			hop_prefactors.push_back(offset.prefactor);
+		}
+		selectHopStencilScan();
+		hops_temp.assign(hop_stencil.size(), Exciton::Hop(this));
+		hop_rates_temp.assign(hop_stencil.size(), 0.0);
+		possible_events_temp.reserve(hop_stencil.size() + 1);
+		uniforms_temp.assign(hop_stencil.size() + 1, 0.0);
+		// Initialize the diffusion distance histogram and the mean squared displacement accumulator
+		diffusion_histogram = createDiffusionHistogram(params);
+		diffusion_msd = createDiffusionMsd(params);
+		// Initialize the Exciton_Creation event
+		R_exciton_generation = params.Exciton_generation_rate * lattice.getNumSites()*intpow(1e-7*lattice.getUnitSize(), 3);
+		// Size the set of occupied sites for twice the expected steady state number of excitons
+		if (params.Enable_sparse_sites) {
+			occupied_sites.reserve((size_t)(2 * R_exciton_generation*params.Exciton_lifetime) + 16);
+		}
+		// Size the site weight cache for four times the neighborhoods of twice the expected steady state number of excitons
+		// The cache is also cleared here, because the weights change when the simulation is reconfigured.
+		site_weight_cache.clear();
+		site_weight_cache_bits = 0;
+		if (params.Enable_sparse_sites || landscape_ptr != nullptr) {
+			const double N_entries_target = 4.0 * (2.0 * R_exciton_generation*params.Exciton_lifetime + 16.0) * (hop_stencil.size() + 1);
+			site_weight_cache_bits = 10;
+			while ((1L << site_weight_cache_bits) < min(N_entries_target, (double)Weight_cache_size_max)) {
+				site_weight_cache_bits++;
+			}
+			site_weight_cache.assign(1L << site_weight_cache_bits, Weight_cache_entry());
+		}
+		exciton_creation_event = Exciton::Creation(this);
+		calculateExecutionTime(exciton_creation_event, R_exciton_generation, rng_creation);
+		if (params.Enable_event_heap) {
+			event_schedule.update(0, exciton_creation_event.getExecutionTime());
+		}
+	}
+
+	// The site energies are static, so the Boltzmann weights only need to be recalculated if the temperature changes
+	// The mean site energy is used as the reference energy, so that the weights of typical sites are close to one
+	void Exciton_sim::calculateBoltzmannWeights() {
+		energy_reference = 0.0;
+		if (params.Enable_sparse_sites || landscape_ptr != nullptr) {
+			return;
+		}
+		double energy_sum = 0.0;
+		for (long int i = 0; i < lattice.getNumSites(); i++) {
+			energy_sum += getSiteEnergy(i);
+		}
+		energy_reference = (lattice.getNumSites() > 0) ? energy_sum / lattice.getNumSites() : 0.0;
+		if (params.Enable_compact_sites) {
+			for (long int i = 0; i < (long int)site_energies_compact.size(); i++) {
+				site_weights_compact[i] = calculateBoltzmannWeight(site_energies_compact[i]);
+			}
+			return;
+		}
+		for (auto& site : sites) {
+			site.setBoltzmannWeight(calculateBoltzmannWeight(site.getEnergy()));
+		}
+	}
+
+	double Exciton_sim::calculateBoltzmannWeight(const double energy) const {
+		const double exponent = -(energy - energy_reference) / (K_b * getTemp());
+		if (exponent > Weight_exponent_max) {
+			return exp(Weight_exponent_max);
+		}
+		if (exponent < -Weight_exponent_max) {
+			return exp(-Weight_exponent_max);
+		}
+		return exp(exponent);
+	}
+
+	double Exciton_sim::calculateHopFactorExact(const long int site_index_dest, const long int site_index_origin) const {
+		const double exponent = -(getSiteEnergy(site_index_dest) - getSiteEnergy(site_index_origin)) / (K_b * getTemp());
+		return (exponent < 0) ? exp(exponent) : 1.0;
+	}
+
+	// Weights that are within the exact range give the same Boltzmann factor as the site energies, so the site energies
+	// are only needed for sites far in the tails of the density of states
+	double Exciton_sim::getHopFactor(const Exciton_slot& exciton_slot, const int n) const {
+		const double weight_dest = exciton_slot.hop_weights[n];
+		if (weight_dest > Weight_exact_min && weight_dest < Weight_exact_max && exciton_slot.weight_origin_inv > Weight_exact_min && exciton_slot.weight_origin_inv < Weight_exact_max) {
+			return min(1.0, weight_dest * exciton_slot.weight_origin_inv);
+		}
+		if (!(weight_dest > 0)) {
+			return 0.0;
+		}
+		const Hop_offset& offset = hop_stencil[n];
+		const Coords& coords = exciton_slot.exciton.getCoords();
+		Coords dest_coords;
+		lattice.calculateDestinationCoords(coords, offset.dx, offset.dy, offset.dz, dest_coords);
+		return calculateHopFactorExact(lattice.getSiteIndex(dest_coords), lattice.getSiteIndex(coords));
+	}
+
 	// Make it easier to get the energy of a particular site in the lattice
 	double Exciton_sim::getSiteEnergy(const Coords& coords) const {
-		return sites[lattice.getSiteIndex(coords)].getEnergy();
+		return getSiteEnergy(lattice.getSiteIndex(coords));
+	}
+
+	double Exciton_sim::getSiteEnergy(const long int site_index) const {
+		if (landscape_ptr != nullptr) {
+			return landscape_ptr->getEnergy(site_index);
+		}
+		if (params.Enable_sparse_sites) {
+			return calculateRandomSiteEnergy(site_index);
+		}
+		if (params.Enable_compact_sites) {
+			return site_energies_compact[site_index];
+		}
+		return sites[site_index].getEnergy();
+	}
+
+	// The site index is multiplied by 2^64 divided by the golden ratio, and the upper bits of the product select the entry
+	double Exciton_sim::getSiteWeightCached(const long int site_index) {
+		if (site_weight_cache.empty()) {
+			return getSiteWeight(site_index);
+		}
+		auto& entry = site_weight_cache[((uint64_t)site_index * 0x9E3779B97F4A7C15ULL) >> (64 - site_weight_cache_bits)];
+		if (entry.site_index != site_index) {
+			entry.site_index = site_index;
+			entry.weight = getSiteWeight(site_index);
+		}
+		return entry.weight;
+	}
+
+	double Exciton_sim::getSiteWeight(const long int site_index) const {
+		if (params.Enable_sparse_sites || landscape_ptr != nullptr) {
+			return calculateBoltzmannWeight(getSiteEnergy(site_index));
+		}
+		if (params.Enable_compact_sites) {
+			return site_weights_compact[site_index];
+		}
+		return sites[site_index].getBoltzmannWeight();
+	}
+
+	// The site energies cannot be set in the sparse site storage mode or when an energy landscape is used
+	void Exciton_sim::setSiteEnergy(const long int site_index, const double energy) {
+		if (params.Enable_sparse_sites || landscape_ptr != nullptr) {
+			return;
+		}
+		if (params.Enable_compact_sites) {
+			site_energies_compact[site_index] = (float)energy;
+		}
+		else {
+			sites[site_index].setEnergy(energy);
+		}
+	}
+
+
+	double Exciton_sim::calculateRandomSiteEnergy(const long int site_index) const {
+		return calculateSiteEnergy(rng_site_energies.getUniform(2 * (uint64_t)site_index), rng_site_energies.getUniform(2 * (uint64_t)site_index + 1));
+	}
+
+	// The uniform random numbers are in the interval [0,1), so the complement of the first one is used to avoid taking the logarithm of zero
+	double Exciton_sim::calculateSiteEnergy(const double uniform1, const double uniform2) const {
+		if (!params.Enable_gaussian_dos && !params.Enable_exponential_dos) {
+			return 0.0;
+		}
+		if (params.Enable_exponential_dos) {
+			return params.Site_energy_urbach * log(1.0 - uniform1);
+		}
+		// Use the Box-Muller transform to create a normally distributed random number
+		return params.Site_energy_stdev * sqrt(-2.0 * log(1.0 - uniform1)) * cos(2.0 * Pi * uniform2);
+	}
+
+	bool Exciton_sim::isSiteOccupied(const long int site_index) const {
+		if (params.Enable_sparse_sites) {
+			return occupied_sites.count(site_index) > 0;
+		}
+		if (params.Enable_compact_sites || landscape_ptr != nullptr) {
+			return site_occupancy_compact[site_index];
+		}
+		return sites[site_index].isOccupied();
+	}
+
+	bool Exciton_sim::isSiteOccupied(const Coords& coords) const {
+		if (params.Enable_sparse_sites) {
+			return occupied_sites.count(lattice.getSiteIndex(coords)) > 0;
+		}
+		return isSiteOccupied(lattice.getSiteIndex(coords));
 	}
 
 }
@@ -6,31 +6,60 @@
 #ifndef EXCITON_SIM_H
 #define EXCITON_SIM_H
 
+#include "Energy_landscape.h"
+#include "Event_heap.h"
+#include "Event_log.h"
 #include "Event.h"
 #include "Exciton.h"
 #include "Object.h"
 #include "Parameters.h"
+#include "Profiler.h"
+#include "Random_stream.h"
+#include "Rate_tree.h"
 #include "Simulation.h"
+#include "Statistics.h"
 #include "Utils.h"
+#include <cstdint>
+#include <deque>
+#include <unordered_set>
 
 namespace KMC_Lattice_example {
 
 	// Derived Site class that adds a site energy property to the lattice.
 	// For simple additions to the Site base class, as is the case here, the derived class can 
 	// be completely defined quickly in the simulation class header. 
+	// Because the site energies do not change during the simulation, each site also stores its
+	// Boltzmann weight, exp(-(E-E_ref)/(K_b*T)) relative to a reference energy, so that the Boltzmann factor of a
+	// hop can be calculated as the ratio of the site weights without evaluating an exponential.
 	class Site_OSC : public KMC_Lattice::Site {
 	public:
 		void setEnergy(const double energy_in) { energy = energy_in; }
 		double getEnergy() const { return energy; }
+		void setBoltzmannWeight(const double weight_in) { boltzmann_weight = weight_in; }
+		double getBoltzmannWeight() const { return boltzmann_weight; }
 	private:
 		double energy = 0.0;
+		double boltzmann_weight = 1.0;
+	};
+
+	// Stores one possible exciton hop displacement in lattice units together with its real space 
+	// distance and its distance-dependent FRET rate prefactor, which only need to be calculated once.
+	struct Hop_offset {
+		int dx;
+		int dy;
+		int dz;
+		double distance; // (nm)
+		double prefactor; // (s^-1)
 	};
 
 	// Derived Simulation class for simulating exciton creation, diffusion, and recombination
 	class Exciton_sim : public KMC_Lattice::Simulation {
 	public:
 		// Constructor that creates an Exciton_sim object with the specified input parameters
-		Exciton_sim(const Parameters& params, const int id);
+		// When a landscape is given, the site energies are read from it instead of being created from the density of
+		// states model.  The landscape must have the same lattice dimensions and unit size as the parameters, and it
+		// must remain open for the lifetime of the simulation.
+		Exciton_sim(const Parameters& params, const int id, const Energy_landscape* landscape_ptr = nullptr);
 
 		// Calculates the average exciton diffusion length of all excitons that have been created 
 		// and recombined so far
@@ -44,13 +73,52 @@ namespace KMC_Lattice_example {
 		// simulation test is complete
 		bool checkFinished() const;
 
+		// Checks whether a simulation created with params_prev has the same lattice and site energies as one
+		// created with params_new with the same id, so that it can be reconfigured instead of reconstructed
+		static bool checkLatticeReusable(const Parameters& params_prev, const Parameters& params_new);
+
 		// This function is designed to be called from main to execute one iteration of the KMC 
 		// algorithm
 		bool executeNextEvent();
 
-		// Get a copy of the diffusion length data vector with the displacement distance of all 
-		// excitons that have been created and recombined so far
-		std::vector<double> getDiffusionData();
+		// Creates an empty histogram with the bins used for the exciton displacement distances, so that
+		// histograms from different simulations with the same parameters can be combined
+		static Histogram createDiffusionHistogram(const Parameters& params);
+
+		// Creates an empty mean squared displacement accumulator with the logarithmic time bins used for the exciton
+		// diffusion transients, so that accumulators from different simulations with the same parameters can be combined
+		static Time_binned_msd createDiffusionMsd(const Parameters& params);
+
+		// Enables storing a uniform random sample of up to sample_size exciton displacement distances,
+		// which should be called before the simulation is started
+		void enableDiffusionSample(const int sample_size);
+
+		// Enables writing a binary log of all executed events to the specified file, which is written by a background
+		// thread and can be converted to a CSV file with the event log reader program.  Returns false if the file cannot
+		// be created.
+		bool enableEventLog(const std::string& filename, const bool Enable_compression);
+
+		// Writes the remaining events to the event log and closes it.  Returns false if the log could not be written completely.
+		bool closeEventLog();
+
+		// Gets the histogram of the displacement distances of all excitons that have been created and 
+		// recombined so far
+		const Histogram& getDiffusionHistogram() const;
+
+		// Gets the time-resolved mean squared displacement of the excitons versus the time since their creation
+		const Time_binned_msd& getDiffusionMsd() const;
+
+		// Gets the random sample of the displacement distances of excitons that have been created and 
+		// recombined so far, which is empty unless it has been enabled
+		const Reservoir_sample& getDiffusionSample() const;
+
+		// Gets the running statistics of the displacement distances of all excitons that have been created
+		// and recombined so far
+		const Running_stats& getDiffusionStats() const;
+
+		// Gets the number of events that have been executed so far, including the events that were executed
+		// before the simulation was restored from a checkpoint
+		long int getN_events_executed() const;
 
 		// Gets the number of excitons that have been created so far
 		int getN_excitons_created();
@@ -58,41 +126,150 @@ namespace KMC_Lattice_example {
 		// Gets the number of excitons that have recombined so far
 		int getN_excitons_recombined();
 
+		// Gets the number of exciton diffusion tests that must be completed before the simulation is finished
+		int getN_tests_target() const;
+
+		// Gets the event counts and timings, which are only recorded when the program is built with profiling enabled
+		const Profiler& getProfiler() const;
+
+		// Sets the number of exciton diffusion tests that must be completed before the simulation is finished,
+		// which allows the simulation to be extended with more tests after it has finished
+		void setN_tests_target(const int N_tests);
+
+		// Restores the complete simulation state from a checkpoint file created by saveCheckpoint.
+		// The simulation must have just been constructed with the same parameters and id as the simulation
+		// that was checkpointed.  Returns false if the file cannot be read or does not match the simulation.
+		bool loadCheckpoint(const std::string& filename);
+
 		// Outputs the current status of the simulation to the command line
 		void outputStatus() const;
 
+		// Predicts the peak number of bytes needed to store the lattice sites and their properties for the
+		// specified parameters, so that it can be checked before any memory is allocated
+		// The memory used by an energy landscape is not included, because it is shared or memory-mapped.
+		static double predictMemoryUsage(const Parameters& params, const bool Enable_landscape);
+
+		// Resets the simulation to the state of a newly constructed simulation with the same id and the new parameters,
+		// which may differ in the temperature, exciton properties, rates, and test settings.  The lattice and site
+		// energies are reused, and only the Boltzmann weights, the lattice data, and the events are recalculated.
+		// Returns false if the new parameters are invalid or need a different lattice or site energy landscape.
+		bool reconfigure(const Parameters& params_new);
+
+		// Runs the exciton diffusion test in the non-interacting limit, where each of the N_walkers excitons is
+		// simulated from creation to recombination as a standalone walker on the site energy landscape without
+		// occupancy checks or the global event queue.  The walkers are split between N_threads threads and the
+		// displacement distances are added to the same diffusion statistics as the normal simulation.
+		// A warning is printed if the exciton density is high enough that exciton interactions are not negligible.
+		void runIndependentWalkers(const int N_walkers, const int N_threads);
+
+		// Writes the complete simulation state to a versioned binary checkpoint file.  The data is first 
+		// written to a temporary file that is then renamed, so an existing checkpoint file is never left
+		// partially written.  Returns false if the file cannot be written.
+		bool saveCheckpoint(const std::string& filename) const;
+
+		// The benchmark program is given access to the private functions so that they can be timed in isolation
+		friend class Exciton_sim_benchmark;
+		friend class Exciton_sim_test;
+
 	protected:
 		// -----------------------------------------------------------------------------------------------
 		// Site storage - One needs to store all sites that make up the lattice in the 
-		// derived simulation class. Pointers to these sites will be used by the Simulation
-		// base class. Use vector because content is constant during the simulation.
+		// derived simulation class. The Lattice object of the Simulation base class is only used for the lattice
+		// geometry, so it is not given pointers to the sites. Use vector because content is constant during the simulation.
 		// -----------------------------------------------------------------------------------------------
 
-		// Vector of sites made up of the derived Site_OSC class objects
+		// Vector of sites made up of the derived Site_OSC class objects, which is empty when compact site 
+		// storage is enabled
 		std::vector<Site_OSC> sites;
 
-		// -----------------------------------------------------------------------------------------------
-		// Object storage - One needs to store each type of object in the simulation. 
-		// Pointers to these objects will by used by the Simulation base class.
-		// Use list for more rapid adding and removing of objects during the simulation. 
-		// -----------------------------------------------------------------------------------------------
-
-		// List of all Exciton objects currently in simulation. 
-		std::list<Exciton> excitons;
+		// When compact site storage is enabled, the site occupancy is stored as one bit per site, and the site energies
+		// are stored in a contiguous float array.  The Boltzmann weights are stored in double precision, because their
+		// range is much larger than the range of single precision numbers.
+		std::vector<bool> site_occupancy_compact;
+		std::vector<float> site_energies_compact;
+		std::vector<double> site_weights_compact;
+
+		// When sparse site storage is enabled, no site data is stored.  The occupancy is instead tracked by the set of
+		// occupied site indices, and the site energies are calculated from the site index when they are needed.
+		std::unordered_set<long int> occupied_sites;
+
+		// When the site energies are calculated or read when they are needed, the Boltzmann weights of the sites that are
+		// used by the event calculations, which are the occupied sites and their neighborhoods, are kept in this direct-mapped
+		// cache, so that the energy and the exponential of a site are not recalculated for every rate update.  Each site index
+		// is mapped to one entry by Fibonacci hashing, and an entry is replaced when another site is mapped to it, so the size
+		// of the cache is fixed when the events are initialized and does not depend on the lattice size.
+		struct Weight_cache_entry {
+			long int site_index = -1;
+			double weight = 0.0;
+		};
+		std::vector<Weight_cache_entry> site_weight_cache;
+		int site_weight_cache_bits = 0;
+
+		// Largest number of entries of the site weight cache
+		static constexpr long int Weight_cache_size_max = 1L << 22;
+
+		// Optional external site energy landscape, which is not owned by the simulation
+		// When it is used, the site_occupancy_compact bits or the sparse site storage track the occupancy, and the 
+		// Boltzmann weights are calculated from the landscape energies when they are needed.
+		const Energy_landscape* landscape_ptr = nullptr;
+
+		// Reference energy of the Boltzmann weights, which is the mean site energy when the site energies are stored and zero when
+		// they are calculated or read when needed.  Only the ratios of the weights are used, so the reference does not change the
+		// hop rates, but it keeps the weights of typical sites close to one.
+		double energy_reference = 0.0;
+
+		// Largest magnitude of the exponent of a Boltzmann weight, which keeps the ratio of any two weights within the range of
+		// double precision numbers
+		static constexpr double Weight_exponent_max = 350.0;
+
+		// Range of the Boltzmann weights that cannot have been limited by Weight_exponent_max.  The Boltzmann factors of hops
+		// from or to sites with weights outside of this range are calculated from the site energies instead of the weights.
+		static constexpr double Weight_exact_min = 1e-150;
+		static constexpr double Weight_exact_max = 1e150;
+
+		// Number of random sites that are tried when looking for an exciton creation site without the empty site index before
+		// the empty sites are counted in a linear scan instead, which only happens when the lattice is nearly full
+		static constexpr int Creation_attempts_max = 64;
 
 		// -----------------------------------------------------------------------------------------------
-		// Event storage - One needs to store each type of event in the simulation.
-		// Pointers to these events will be used by the Simulation base class.
-		// Use list for more rapid adding and removing of events during the simulation.
+		// Object and Event storage - One needs to store each type of object and event in the simulation.
+		// The excitons and their events are not registered with the object and event lists of the Simulation
+		// base class, which are searched linearly, but pointers to them are passed between the event selection
+		// and execute functions, so their addresses must not change while they are in use.
 		// -----------------------------------------------------------------------------------------------
 
-		// List of all Exciton_Hop events in the simulation, one for each Exciton currently in the 
-		// simulation.
-		std::list<Exciton::Hop> exciton_hop_events;
-
-		// List of all Exiton_Recombunation events in the simulation, one for each Exciton currently 
-		// in the simulation.
-		std::list<Exciton::Recombination> exciton_recombination_events;
+		// Each Exciton is stored in a pooled slot together with its paired Exciton_Hop and 
+		// Exciton_Recombination events. The slot index is a stable handle that is saved in the Exciton,
+		// so the events of an exciton can be accessed directly without searching.
+		struct Exciton_slot {
+			Exciton_slot(KMC_Lattice::Simulation* sim_ptr) : exciton(0.0, 0, KMC_Lattice::Coords(0, 0, 0)), hop_event(sim_ptr), recombination_event(sim_ptr) {}
+			Exciton exciton;
+			Exciton::Hop hop_event;
+			Exciton::Recombination recombination_event;
+			// Code of the event that is currently selected for the exciton
+			Exciton::Event_code selected_event_code = Exciton::Event_code::Recombination;
+			bool is_active = false;
+			// Hop rate table of the exciton, which stores the Boltzmann weight of the destination site of each hop_stencil
+			// entry or zero if the hop is not possible, the inverse Boltzmann weight of the exciton's site, the hop rates in a
+			// Fenwick tree, and the total of the hop rates.  It is updated when nearby sites change occupancy and calculated
+			// from scratch only when the exciton is created or moves.  The Fenwick tree allows a hop to be selected and a hop
+			// rate to be changed in O(log N) time, and it is rebuilt after every N changes to limit the rounding errors.
+			std::vector<double> hop_weights;
+			double weight_origin_inv = 1.0;
+			Rate_tree hop_rates;
+			double hop_rate_total = 0.0;
+			// Time of the last hop of the exciton, or its creation time if it has not hopped, which is the start of the time
+			// interval that has not yet been added to the mean squared displacement accumulator
+			double time_displaced = 0.0;
+		};
+
+		// Pool of all Exciton slots in the simulation. Use deque because it does not relocate existing
+		// elements when the pool grows.  Slots are recycled after their exciton recombines, so new slots 
+		// are only allocated when the number of excitons exceeds the previous maximum.
+		std::deque<Exciton_slot> exciton_slots;
+
+		// Indices of the slots in the exciton_slots pool that are not currently in use.
+		std::vector<int> free_slots;
 
 		// Single Exciton_Creation event - No list is needed because there is only ever one of these 
 		// events in the simulation.
@@ -110,15 +287,77 @@ namespace KMC_Lattice_example {
 		// Defines the rate constant for exciton generation, which is calculated based on the input params
 		double R_exciton_generation;
 
+		// Defines the hop stencil, which is the list of all lattice displacements that are within the
+		// FRET cutoff radius and their precomputed hop rate prefactors.  It is built in the constructor
+		// so that each simulation instance uses its own FRET_cutoff and Unit_size.
+		std::vector<Hop_offset> hop_stencil;
+
+		// Pre-allocated hop events, one for each hop_stencil entry, so that all events in the neighbor
+		// search do not need to be re-created each time calculateExcitonEvents is called
+		std::vector<Exciton::Hop> hops_temp;
+
+		// Hop range in lattice units and the index of the hop_stencil entry for each lattice displacement within the
+		// hop range, or -1 if the displacement is outside of the FRET cutoff radius, so that the hop rate table entries
+		// for a site can be found without searching the stencil
+		int hop_range = 0;
+		std::vector<int> hop_stencil_lookup;
+
+		// Neighbor scan function that fills the hop rate table of an exciton, which is selected from the scanHopStencil
+		// specializations for the periodic boundary conditions of the lattice and the hop range when the events are initialized
+		void (Exciton_sim::*scan_hop_stencil)(Exciton_slot& exciton_slot) = nullptr;
+
+		// Rate prefactors of the hop_stencil entries and a pre-allocated work array for the hop rates of an exciton, which
+		// are calculated when its hop rate table is calculated from scratch
+		std::vector<double> hop_prefactors;
+		std::vector<double> hop_rates_temp;
+
+		// Pre-allocated work arrays for the possible events of an exciton and the uniform random numbers that are drawn in one
+		// batch for them in the first reaction method
+		std::vector<KMC_Lattice::Event*> possible_events_temp;
+		std::vector<double> uniforms_temp;
+
+		// Pre-allocated work array for the slot indices of the excitons whose events must be recalculated after an event
+		std::vector<int> recalc_slots;
+
+		// Total event rate of the exciton in each slot of the exciton_slots pool, which is only used by the global
+		// BKL engine to select the next exciton with probability proportional to its total rate
+		Rate_tree exciton_rates;
+
+		// Execution time of the selected event of each exciton and of the exciton creation event, which is only used by the
+		// event heap scheduler instead of checking the selected events of all excitons.  Handle 0 is the exciton creation event
+		// and handle n is the selected event of the exciton in slot n-1 of the exciton_slots pool.
+		Event_heap event_schedule;
+
+		// Indices of all unoccupied lattice sites, stored in no particular order so that a random empty site 
+		// can be selected in constant time at any lattice occupancy.
+		std::vector<long int> empty_site_indices;
+
+		// Position of each lattice site in the empty_site_indices vector, or -1 if the site is occupied.
+		std::vector<long int> empty_site_positions;
+
 		// -----------------------------------------------------------------------------------------------
 		// Additional Data Structures - One can define a variety of additional data structures for storing 
 		// data needed by any of the simulation tests.
 		// -----------------------------------------------------------------------------------------------
 
 		// In this simulation, there is only one test, called the exciton diffusion test
-		// To generate diffusion length results, here we use a simple vector for storing the displacement
-		// distance of each Exciton once it recombines
-		std::vector<double> diffusion_distances;
+		// To generate diffusion length results, the displacement distance of each Exciton is added to
+		// streaming accumulators once it recombines, so memory usage does not grow with the number of tests
+		// Running mean and standard deviation of the displacement distances
+		Running_stats diffusion_stats;
+
+		// Histogram of the displacement distances
+		Histogram diffusion_histogram;
+
+		// Optional random sample of the displacement distances
+		Reservoir_sample diffusion_sample;
+
+		// Mean squared displacement of the excitons versus the time since their creation, which is updated whenever an
+		// exciton hops or recombines with the squared displacement it had since its previous hop
+		Time_binned_msd diffusion_msd;
+
+		// Optional log of all executed events
+		Event_log event_log;
 
 		// -----------------------------------------------------------------------------------------------
 		// Additional Counters - One can define a variety of additional counters to keep track of how many 
@@ -134,14 +373,95 @@ namespace KMC_Lattice_example {
 		// Keep track of how many Exciton_Recombination events have occurred so far.
 		int N_excitons_recombined = 0;
 
+		// Keep track of how many events were executed before the simulation was restored from a checkpoint
+		long int N_events_executed_restored = 0;
+
+		// Keep track of how many events have been executed, which is counted here because the event selection of the
+		// Simulation base class, which has its own event counter, is not used
+		long int N_events_executed_direct = 0;
+
+		// Keep track of how many exciton diffusion tests must be completed, which is initially set by the
+		// N_tests parameter
+		int N_tests_target = 0;
+
+		// Keep track of how many times each event type and each phase of the event calculation is executed
+		// and how long they take when profiling is enabled
+		Profiler profiler;
+
+		// Purpose ids of the counter-based random number streams of each simulation
+		enum class Random_purpose : unsigned int { Site_energies, Exciton_creation, Exciton_events, Independent_walkers };
+
+		// Seed of the counter-based random number streams, which is the Random_seed parameter if it is set or is otherwise
+		// drawn from the random number generator of the Simulation base class when the simulation is constructed
+		uint64_t random_seed = 0;
+
+		// Counter-based random number streams of the simulation, which are identified by the seed, the simulation id, and
+		// their purpose, so that the random numbers of a simulation do not depend on the processor or thread that runs it.
+		// The site energy of each site is created from the outputs of the site energy stream at positions that are given by
+		// the site index.  The exciton creation stream is used for the exciton creation times and coordinates, and the
+		// exciton event stream is used for the execution times and the selection of the exciton events.
+		Random_stream rng_site_energies;
+		Random_stream rng_creation;
+		Random_stream rng_events;
+
 		// -----------------------------------------------------------------------------------------------
 		// Calculate event functions - One should define "calculate events" functions for each type of
 		// object in the simulation that will calculate all of the possible events for each object type
 		// -----------------------------------------------------------------------------------------------
 
-		// Calculates all possible events for the specified Exciton that are declared in the Exciton class. 
+		// Calculates all possible events for the specified Exciton that are declared in the Exciton class from its hop rate table. 
+		// With the global BKL engine, only the total rate of the exciton is stored in the rate tree.
 		void calculateExcitonEvents(Exciton* exciton_it);
 
+		// Calculates the hop rate table of the exciton in the specified slot from scratch by checking all sites in the hop stencil
+		void calculateHopRateTable(Exciton_slot& exciton_slot);
+
+		// Fills the hop weights of the hop rate table of the exciton in the specified slot by checking all sites within the hop
+		// range.  The function is specialized on the periodic boundary conditions of each axis and on the hop range, so that the
+		// stencil loops can be unrolled and the boundary checks are removed for periodic axes.  Exciton sites that are at least
+		// the hop range away from all lattice boundaries skip the boundary checks entirely.  When Range is zero, the hop range is
+		// read from hop_range at runtime.
+		template<bool Periodic_x, bool Periodic_y, bool Periodic_z, int Range>
+		void scanHopStencil(Exciton_slot& exciton_slot);
+
+		// Selects the scanHopStencil specialization for the current lattice and hop range from the dispatch table
+		void selectHopStencilScan();
+
+		// Updates the hop rate table entries of the exciton in the specified slot for hops to the site at the specified
+		// coordinates, which now has the specified destination weight, and updates the Fenwick tree and total of the hop rates
+		void updateHopRateTable(Exciton_slot& exciton_slot, const KMC_Lattice::Coords& site_coords, const double weight_site);
+
+		// Selects the next event of the global BKL engine by choosing the exciton creation event or one exciton with
+		// probability proportional to its total rate from the rate tree and then choosing one of the events of the
+		// selected exciton.  The simulation time is advanced by an exponentially distributed waiting time.
+		KMC_Lattice::Event* chooseNextEventGlobal();
+
+		// Selects the next event of the default engine by checking the selected event of every exciton and the exciton
+		// creation event and choosing the one with the earliest execution time
+		KMC_Lattice::Event* chooseNextEventScan();
+
+		// Selects the recombination event or one of the hops in the hop rate table of the exciton in the specified slot
+		// with probability proportional to its rate, sets up the selected event in the slot, and returns it.
+		KMC_Lattice::Event* selectExcitonEvent(Exciton_slot& exciton_slot);
+
+		// Adds the squared displacement of the exciton from its previous hop until the current time to the mean squared
+		// displacement accumulator
+		void updateDiffusionMsd(Exciton_slot& exciton_slot);
+
+		// Finds all excitons that are close enough to the initial or destination coordinates of an executed event to
+		// be affected by it, updates their hop rate tables for the sites whose occupancy changed, and recalculates their events.
+		void recalculateNeighborEvents(const KMC_Lattice::Coords& coords_initial, const KMC_Lattice::Coords& coords_dest);
+
+		// Fills recalc_slots with the slot indices of all excitons when the full recalculation method is used, or of the excitons
+		// within the recalculation cutoff radius of the initial or destination coordinates when the selective recalculation
+		// method is used.  This replaces the findRecalcObjects function of the Simulation base class, which searches its object
+		// list in the same way, because the excitons are not stored in that list.
+		void findRecalcExcitons(const KMC_Lattice::Coords& coords_initial, const KMC_Lattice::Coords& coords_dest);
+
+		// Calculates the squared distance in lattice units between the specified coordinates, where the distance along each
+		// periodic axis is the shorter of the direct distance and the distance across the boundary
+		long int calculateLatticeDistanceSquared(const KMC_Lattice::Coords& coords_start, const KMC_Lattice::Coords& coords_end) const;
+
 		// -----------------------------------------------------------------------------------------------
 		// Execute event functions - One should define "execute event" functions for each type of event
 		// for each type of Object in the simulation.
@@ -149,15 +469,15 @@ namespace KMC_Lattice_example {
 
 		// Execute the exciton creation event and return true if the event is successful or false an 
 		// error occurs.
-		bool executeExcitonCreation(const std::list<KMC_Lattice::Event*>::const_iterator event_it);
+		bool executeExcitonCreation(KMC_Lattice::Event* event_ptr);
 
 		// Execute the exciton hop event and return true if the event is successful or false an error 
 		// occurs.
-		bool executeExcitonHop(const std::list<KMC_Lattice::Event*>::const_iterator event_it);
+		bool executeExcitonHop(KMC_Lattice::Event* event_ptr);
 
 		// Execute the exciton recombination event and return true if the event is successful or false an 
 		// error occurs.
-		bool executeExcitonRecombination(const std::list<KMC_Lattice::Event*>::const_iterator event_it);
+		bool executeExcitonRecombination(KMC_Lattice::Event* event_ptr);
 
 		// -----------------------------------------------------------------------------------------------
 		// Delete object functions - One should define "delete object" functions for each object type in 
@@ -180,13 +500,85 @@ namespace KMC_Lattice_example {
 		// The code in this function could be rolled into the executeExcitonCreation function if desired.
 		KMC_Lattice::Coords calculateExcitonCreationCoords();
 
-		// This utility function provide an easy reusable conversion from Exciton pointer to Exciton 
-		// list iterator for an alternative way to access the Exciton object
-		std::list<Exciton>::iterator getExcitonIt(const Exciton* exciton_ptr);
+		// This function sets the execution time of the event by drawing an exponentially distributed waiting time with the
+		// specified total rate from the specified random number stream
+		void calculateExecutionTime(KMC_Lattice::Event& event, const double rate, Random_stream& stream);
+
+		// This function sets the seed of the exciton creation and exciton event streams and moves them to their start,
+		// which does not change the site energies
+		void seedEventStreams(const uint64_t seed);
+
+		// This function simulates one independent exciton walker from a random creation site until it recombines
+		// and returns its displacement distance in nm.  It only reads the simulation state, so it can be called from
+		// several threads at once, each with its own random number stream and work arrays.
+		double simulateIndependentWalker(Random_stream& walker_stream, std::vector<double>& prefactors, std::vector<double>& weights, std::vector<double>& rates_cumulative) const;
+
+		// This utility function provides an easy reusable way to get an unused Exciton slot from the pool,
+		// which is either a recycled slot or a newly allocated one, and returns its index.
+		int allocateExcitonSlot();
+
+		// This utility function adds an executed event to the event log if the event log is enabled
+		void logEvent(const Exciton::Event_code event_code, const int tag, const KMC_Lattice::Coords& coords_initial, const KMC_Lattice::Coords& coords_dest);
+
+		// These utility functions keep the empty site index up to date when the site with the specified
+		// index becomes occupied or empty.
+		void markSiteOccupied(const long int site_index);
+		void markSiteEmpty(const long int site_index);
+
+		// This utility function calculates the Boltzmann weight of every site from its energy at the 
+		// current simulation temperature.
+		void calculateBoltzmannWeights();
+
+		// This utility function calculates the Boltzmann weight of a site with the specified energy relative to the reference
+		// energy at the current simulation temperature.  The exponent is limited to +/-Weight_exponent_max, so that the weights
+		// and the ratios of any two weights are finite and positive even for very wide disorder or very low temperatures.
+		double calculateBoltzmannWeight(const double energy) const;
+
+		// This utility function calculates the Boltzmann factor of a hop, min(1, exp(-E_delta/(K_b*T))), directly from the
+		// energies of the destination and initial sites
+		double calculateHopFactorExact(const long int site_index_dest, const long int site_index_origin) const;
+
+		// This utility function gets the Boltzmann factor of the specified hop_stencil entry of an exciton from its hop rate
+		// table, which is zero if the hop is not possible.  It is the ratio of the destination and initial site weights unless
+		// either weight may have been limited by Weight_exponent_max, in which case it is calculated from the site energies.
+		double getHopFactor(const Exciton_slot& exciton_slot, const int n) const;
+
+		// These utility functions initialize the empty site index and the hop stencil and exciton creation event for the
+		// current parameters.
+		void initializeEmptySiteIndex();
+		void initializeEvents();
 
 		// This utility function provides an easier reusable way to get the energy of the site at the
 		// specified coordinates.
 		double getSiteEnergy(const KMC_Lattice::Coords& coords) const;
+
+		// These utility functions get and set the properties of the site with the specified index from either
+		// the Site_OSC objects or the compact site arrays.
+		double getSiteEnergy(const long int site_index) const;
+		double getSiteWeight(const long int site_index) const;
+		void setSiteEnergy(const long int site_index, const double energy);
+
+		// This utility function gets the Boltzmann weight of the site with the specified index from the site weight cache when
+		// the site energies are calculated or read when they are needed, and from the site storage otherwise.  It is used by the
+		// event calculations, while getSiteWeight is used by the independent walkers, which run in several threads.
+		double getSiteWeightCached(const long int site_index);
+
+		// This utility function calculates the energy of the site with the specified index from the outputs of the site
+		// energy stream at twice the site index and twice the site index plus one, which is used to create the uncorrelated
+		// site energies and to calculate the site energies when they are needed in the sparse site storage mode.
+		double calculateRandomSiteEnergy(const long int site_index) const;
+
+		// This utility function calculates a site energy from the selected density of states model and two uniform random
+		// numbers in the interval [0,1)
+		double calculateSiteEnergy(const double uniform1, const double uniform2) const;
+
+		// This utility function checks whether the site at the specified coordinates is occupied using either the
+		// Lattice class or the set of occupied sites.
+		bool isSiteOccupied(const KMC_Lattice::Coords& coords) const;
+
+		// This utility function checks whether the site with the specified index is occupied using either the site objects or
+		// the set of occupied sites.
+		bool isSiteOccupied(const long int site_index) const;
 	};
 
 }
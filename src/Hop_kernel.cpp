@@ -0,0 +1,117 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#include "Hop_kernel.h"
+#include <algorithm>
+
+// The vectorized kernels are compiled for their target instruction sets using function attributes and are
+// selected at runtime, so the default build flags do not need to enable AVX2 or AVX-512.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(__PGI) && !defined(__NVCOMPILER)
+#define HOP_KERNEL_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace KMC_Lattice_example {
+
+	namespace {
+
+		// Scalar version of the kernel that processes candidates [start, N) and continues the cumulative
+		// sum from rate_sum. The vectorized kernels use it for the remaining candidates.
+		double calculateHopRates_scalar(const double* prefactors, const double* weights_dest, const double weight_origin_inv, const int start, const int N, double rate_sum, double* rates_cumulative) {
+			for (int i = start; i < N; i++) {
+				rate_sum += prefactors[i] * min(1.0, weights_dest[i] * weight_origin_inv);
+				rates_cumulative[i] = rate_sum;
+			}
+			return rate_sum;
+		}
+
+#ifdef HOP_KERNEL_X86_DISPATCH
+		// AVX2 version of the kernel that processes four candidates per iteration.
+		// The prefix sum within each vector is calculated with two shift and add steps.
+		__attribute__((target("avx2")))
+		double calculateHopRates_avx2(const double* prefactors, const double* weights_dest, const double weight_origin_inv, const int N, double* rates_cumulative) {
+			const __m256d zero = _mm256_setzero_pd();
+			const __m256d one = _mm256_set1_pd(1.0);
+			const __m256d ratio_factor = _mm256_set1_pd(weight_origin_inv);
+			__m256d carry = zero;
+			int i = 0;
+			for (; i + 4 <= N; i += 4) {
+				__m256d ratio = _mm256_mul_pd(_mm256_loadu_pd(weights_dest + i), ratio_factor);
+				__m256d rates = _mm256_mul_pd(_mm256_loadu_pd(prefactors + i), _mm256_min_pd(one, ratio));
+				// Shift by one lane: [0, r0, r1, r2]
+				rates = _mm256_add_pd(rates, _mm256_blend_pd(_mm256_permute4x64_pd(rates, _MM_SHUFFLE(2, 1, 0, 3)), zero, 0x1));
+				// Shift by two lanes: [0, 0, s0, s1]
+				rates = _mm256_add_pd(rates, _mm256_blend_pd(_mm256_permute4x64_pd(rates, _MM_SHUFFLE(1, 0, 3, 2)), zero, 0x3));
+				rates = _mm256_add_pd(rates, carry);
+				_mm256_storeu_pd(rates_cumulative + i, rates);
+				// Broadcast the last lane as the carry for the next iteration
+				carry = _mm256_permute4x64_pd(rates, _MM_SHUFFLE(3, 3, 3, 3));
+			}
+			double rate_sum = (i > 0) ? rates_cumulative[i - 1] : 0.0;
+			return calculateHopRates_scalar(prefactors, weights_dest, weight_origin_inv, i, N, rate_sum, rates_cumulative);
+		}
+
+		// AVX-512 version of the kernel that processes eight candidates per iteration.
+		// The prefix sum within each vector is calculated with three masked shift and add steps.
+		__attribute__((target("avx512f")))
+		double calculateHopRates_avx512(const double* prefactors, const double* weights_dest, const double weight_origin_inv, const int N, double* rates_cumulative) {
+			const __m512d one = _mm512_set1_pd(1.0);
+			const __m512d ratio_factor = _mm512_set1_pd(weight_origin_inv);
+			const __m512i shift1 = _mm512_set_epi64(6, 5, 4, 3, 2, 1, 0, 0);
+			const __m512i shift2 = _mm512_set_epi64(5, 4, 3, 2, 1, 0, 0, 0);
+			const __m512i shift4 = _mm512_set_epi64(3, 2, 1, 0, 0, 0, 0, 0);
+			const __m512i last = _mm512_set1_epi64(7);
+			__m512d carry = _mm512_setzero_pd();
+			int i = 0;
+			for (; i + 8 <= N; i += 8) {
+				__m512d ratio = _mm512_mul_pd(_mm512_loadu_pd(weights_dest + i), ratio_factor);
+				__m512d rates = _mm512_mul_pd(_mm512_loadu_pd(prefactors + i), _mm512_maskz_min_pd((__mmask8)0xFF, one, ratio));
+				rates = _mm512_add_pd(rates, _mm512_maskz_permutexvar_pd((__mmask8)0xFE, shift1, rates));
+				rates = _mm512_add_pd(rates, _mm512_maskz_permutexvar_pd((__mmask8)0xFC, shift2, rates));
+				rates = _mm512_add_pd(rates, _mm512_maskz_permutexvar_pd((__mmask8)0xF0, shift4, rates));
+				rates = _mm512_add_pd(rates, carry);
+				_mm512_storeu_pd(rates_cumulative + i, rates);
+				carry = _mm512_maskz_permutexvar_pd((__mmask8)0xFF, last, rates);
+			}
+			double rate_sum = (i > 0) ? rates_cumulative[i - 1] : 0.0;
+			return calculateHopRates_scalar(prefactors, weights_dest, weight_origin_inv, i, N, rate_sum, rates_cumulative);
+		}
+#endif
+
+		double calculateHopRates_default(const double* prefactors, const double* weights_dest, const double weight_origin_inv, const int N, double* rates_cumulative) {
+			return calculateHopRates_scalar(prefactors, weights_dest, weight_origin_inv, 0, N, 0.0, rates_cumulative);
+		}
+
+		typedef double(*Hop_kernel_function)(const double*, const double*, const double, const int, double*);
+
+		// Selects the fastest kernel version that is supported by the processor
+		Hop_kernel_function selectHopKernel() {
+#ifdef HOP_KERNEL_X86_DISPATCH
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx512f")) {
+				return &calculateHopRates_avx512;
+			}
+			if (__builtin_cpu_supports("avx2")) {
+				return &calculateHopRates_avx2;
+			}
+#endif
+			return &calculateHopRates_default;
+		}
+
+	}
+
+	double calculateHopRates(const double* prefactors, const double* weights_dest, const double weight_origin_inv, const int N, double* rates_cumulative) {
+		// The kernel selection is only performed once per process
+		static const Hop_kernel_function kernel = selectHopKernel();
+		return kernel(prefactors, weights_dest, weight_origin_inv, N, rates_cumulative);
+	}
+
+	double calculateHopRatesScalar(const double* prefactors, const double* weights_dest, const double weight_origin_inv, const int N, double* rates_cumulative) {
+		return calculateHopRates_default(prefactors, weights_dest, weight_origin_inv, N, rates_cumulative);
+	}
+
+}
@@ -0,0 +1,31 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#ifndef HOP_KERNEL_H
+#define HOP_KERNEL_H
+
+namespace KMC_Lattice_example {
+
+	// Calculates the FRET rate constants of N candidate exciton hops and their cumulative sum in one pass.
+	// The rate of candidate i is prefactors[i]*min(1, weights_dest[i]*weight_origin_inv), where the weights
+	// are the Boltzmann weights, exp(-(E-E_ref)/(K_b*T)), of the destination sites and weight_origin_inv is the
+	// inverse of the Boltzmann weight of the initial site. This gives the same result as the Boltzmann factor
+	// exp(-E_delta/(K_b*T)) for uphill hops without evaluating any exponentials.
+	// The cumulative sum of the rates is stored in rates_cumulative, which must have space for N values,
+	// and the total rate of all candidates is returned.
+	// An AVX-512 or AVX2 version of the kernel is used when the processor supports it, and otherwise a
+	// scalar version is used.  The vectorized versions add the rates in a different order than the scalar
+	// version, so the cumulative rates can differ in the last bits between processors.
+	// The kernel is only used by the independent walker engine of Exciton_sim.  The event-driven engines keep
+	// the hop rates of each exciton in a Rate_tree and never call it.
+	double calculateHopRates(const double* prefactors, const double* weights_dest, const double weight_origin_inv, const int N, double* rates_cumulative);
+
+	// Calculates the same rates as calculateHopRates using only the scalar version of the kernel, which adds the
+	// rates in order, so that the cumulative rates are the same on every processor.
+	double calculateHopRatesScalar(const double* prefactors, const double* weights_dest, const double weight_origin_inv, const int N, double* rates_cumulative);
+
+}
+
+#endif // HOP_KERNEL_H
@@ -0,0 +1,64 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#include "Parameter_sweep.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+namespace KMC_Lattice_example {
+
+	bool Parameter_sweep::importSweep(ifstream& inputfile, const Parameters& params_base) {
+		configs.clear();
+		parameter_names.clear();
+		int line_number = 0;
+		string line;
+		while (getline(inputfile, line)) {
+			line_number++;
+			istringstream stream(line);
+			string item;
+			if (!(stream >> item) || item.compare(0, 2, "##") == 0) {
+				continue;
+			}
+			Parameters params = params_base;
+			do {
+				auto pos = item.find('=');
+				string name = item.substr(0, pos);
+				if (pos == string::npos || !params.setParameter(name, item.substr(pos + 1))) {
+					cout << "Error! Parameter override " << item << " on line " << line_number << " of the sweep file is not valid." << endl;
+					return false;
+				}
+				if (find(parameter_names.begin(), parameter_names.end(), name) == parameter_names.end()) {
+					parameter_names.push_back(name);
+				}
+			} while (stream >> item);
+			if (!params.checkParameters()) {
+				cout << "Error! The configuration on line " << line_number << " of the sweep file has invalid parameters." << endl;
+				return false;
+			}
+			configs.push_back(params);
+		}
+		if (configs.empty()) {
+			cout << "Error! The sweep file does not contain any configurations." << endl;
+			return false;
+		}
+		return true;
+	}
+
+	int Parameter_sweep::getN_configs() const {
+		return (int)configs.size();
+	}
+
+	const vector<string>& Parameter_sweep::getParameterNames() const {
+		return parameter_names;
+	}
+
+	const Parameters& Parameter_sweep::getParams(const int config_index) const {
+		return configs[config_index];
+	}
+
+}
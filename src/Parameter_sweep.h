@@ -0,0 +1,42 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#ifndef PARAMETER_SWEEP_H
+#define PARAMETER_SWEEP_H
+
+#include "Parameters.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace KMC_Lattice_example {
+
+	// This class stores the configurations of a parameter sweep, which are read from a sweep file.
+	// Each line of the sweep file defines one configuration as a list of Name=value overrides of the base parameters
+	// separated by spaces, where Name is the name of the parameter in the parameter file.  Blank lines and lines
+	// starting with ## are ignored.
+	class Parameter_sweep {
+	public:
+		// Imports the configurations from the sweep file and checks that the parameters of each configuration are valid.
+		// Returns false if an override cannot be parsed or a configuration has invalid parameters.
+		bool importSweep(std::ifstream& inputfile, const Parameters& params_base);
+
+		// Gets the number of configurations in the sweep
+		int getN_configs() const;
+
+		// Gets the names of all parameters that are overridden by any configuration in the order of their first appearance
+		const std::vector<std::string>& getParameterNames() const;
+
+		// Gets the complete parameters of the specified configuration
+		const Parameters& getParams(const int config_index) const;
+
+	private:
+		std::vector<Parameters> configs;
+		std::vector<std::string> parameter_names;
+	};
+
+}
+
+#endif // PARAMETER_SWEEP_H
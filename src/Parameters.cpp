@@ -4,12 +4,33 @@
 // The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
 
 #include "Parameters.h"
+#include <sstream>
 
 using namespace std;
 using namespace KMC_Lattice;
 
 namespace KMC_Lattice_example {
 
+	// Parses a value of the same type as the parameter and only changes the parameter if the whole string is valid
+	template<typename T>
+	static bool parseParameter(const string& str, T& parameter) {
+		istringstream stream(str);
+		T value;
+		stream >> value;
+		if (stream.fail() || !(stream >> ws).eof()) {
+			return false;
+		}
+		parameter = value;
+		return true;
+	}
+
+	template<typename T>
+	static string formatParameter(const T& parameter) {
+		ostringstream stream;
+		stream << parameter;
+		return stream.str();
+	}
+
 	Parameters::Parameters() {}
 
 	bool Parameters::checkParameters() const {
@@ -37,6 +58,14 @@ namespace KMC_Lattice_example {
 			cout << "Error! When using the Gaussian disorder model, the standard deviation cannot be negative." << endl;
 			return false;
 		}
+		if (Enable_correlated_disorder && !Enable_gaussian_dos) {
+			cout << "Error! The correlated disorder model can only be used with the Gaussian disorder model." << endl;
+			return false;
+		}
+		if (Enable_correlated_disorder && Disorder_correlation_length < 0) {
+			cout << "Error! When using the correlated disorder model, the correlation length cannot be negative." << endl;
+			return false;
+		}
 		if (Enable_exponential_dos && Site_energy_urbach < 0) {
 			cout << "Error! When using the exponential disorder model, the Urbach energy cannot be negative." << endl;
 			return false;
@@ -184,6 +213,91 @@ namespace KMC_Lattice_example {
 		i++;
 		Site_energy_urbach = atof(stringvars[i].c_str());
 		i++;
+		// Correlated Disorder Parameters
+		// These parameters were added at the end of the file, so parameter files from previous versions that do not contain
+		// them can still be imported, and the correlated disorder model is then disabled.
+		if (i + 1 < (int)stringvars.size() && !stringvars[i].empty()) {
+			//enable_correlated_disorder
+			try {
+				Enable_correlated_disorder = str2bool(stringvars[i]);
+			}
+			catch (invalid_argument& exception) {
+				cout << exception.what() << endl;
+				cout << "Error setting correlated disorder options" << endl;
+				return false;
+			}
+			i++;
+			Disorder_correlation_length = atof(stringvars[i].c_str());
+			i++;
+		}
 		return true;
 	}
+
+	string Parameters::getParameter(const string& name) const {
+		if (name.compare("Temperature") == 0) {
+			return formatParameter(Temperature);
+		}
+		if (name.compare("Recalc_cutoff") == 0) {
+			return formatParameter(Recalc_cutoff);
+		}
+		if (name.compare("N_tests") == 0) {
+			return formatParameter(N_tests);
+		}
+		if (name.compare("Exciton_generation_rate") == 0) {
+			return formatParameter(Exciton_generation_rate);
+		}
+		if (name.compare("Exciton_lifetime") == 0) {
+			return formatParameter(Exciton_lifetime);
+		}
+		if (name.compare("R_exciton_hopping") == 0) {
+			return formatParameter(R_exciton_hopping);
+		}
+		if (name.compare("FRET_cutoff") == 0) {
+			return formatParameter(FRET_cutoff);
+		}
+		if (name.compare("Site_energy_stdev") == 0) {
+			return formatParameter(Site_energy_stdev);
+		}
+		if (name.compare("Disorder_correlation_length") == 0) {
+			return formatParameter(Disorder_correlation_length);
+		}
+		if (name.compare("Site_energy_urbach") == 0) {
+			return formatParameter(Site_energy_urbach);
+		}
+		return "";
+	}
+
+	bool Parameters::setParameter(const string& name, const string& value) {
+		if (name.compare("Temperature") == 0) {
+			return parseParameter(value, Temperature);
+		}
+		if (name.compare("Recalc_cutoff") == 0) {
+			return parseParameter(value, Recalc_cutoff);
+		}
+		if (name.compare("N_tests") == 0) {
+			return parseParameter(value, N_tests);
+		}
+		if (name.compare("Exciton_generation_rate") == 0) {
+			return parseParameter(value, Exciton_generation_rate);
+		}
+		if (name.compare("Exciton_lifetime") == 0) {
+			return parseParameter(value, Exciton_lifetime);
+		}
+		if (name.compare("R_exciton_hopping") == 0) {
+			return parseParameter(value, R_exciton_hopping);
+		}
+		if (name.compare("FRET_cutoff") == 0) {
+			return parseParameter(value, FRET_cutoff);
+		}
+		if (name.compare("Site_energy_stdev") == 0) {
+			return parseParameter(value, Site_energy_stdev);
+		}
+		if (name.compare("Disorder_correlation_length") == 0) {
+			return parseParameter(value, Disorder_correlation_length);
+		}
+		if (name.compare("Site_energy_urbach") == 0) {
+			return parseParameter(value, Site_energy_urbach);
+		}
+		return false;
+	}
 }
@@ -8,6 +8,7 @@
 
 #include "Parameters_Simulation.h"
 #include "Utils.h"
+#include <cstdint>
 #include <fstream>
 #include <vector>
 #include <string>
@@ -31,6 +32,16 @@ namespace KMC_Lattice_example {
 		// to parse whatever type of parameter file format they prefer to use.
 		bool importParameters(std::ifstream& inputfile);
 
+		// Gets the value of the numerical parameter with the specified parameter file name as a string, which is
+		// empty if the parameter cannot be accessed by name
+		std::string getParameter(const std::string& name) const;
+
+		// Sets the numerical parameter with the specified parameter file name to the value parsed from the string, 
+		// which allows individual parameters to be overridden, such as in a parameter sweep.  The lattice dimensions
+		// and the boolean options cannot be set by name.  Returns false if the parameter cannot be set by name or the 
+		// value cannot be parsed.
+		bool setParameter(const std::string& name, const std::string& value);
+
 		// -----------------------------------------------------------------------------------------------
 		// Test Parameters - Users should define what types of tests can be run using the simulation and
 		// create boolean "enable" parameters that users will use to select one of the possible tests.
@@ -68,12 +79,58 @@ namespace KMC_Lattice_example {
 		bool Enable_gaussian_dos = false;
 		// This parameter defines the standard deviation of the Gaussian distribution
 		double Site_energy_stdev = 0.0; // (eV)
+		// This parameter is used to add spatial correlation to the Gaussian site energies, which are then
+		// created by convolving uncorrelated Gaussian noise with a Gaussian kernel
+		bool Enable_correlated_disorder = false;
+		// This parameter defines the correlation length of the correlated Gaussian site energies, where the
+		// energy correlation function decays as exp(-r^2/(2*Disorder_correlation_length^2))
+		double Disorder_correlation_length = 0.0; // (nm)
 		// This parameters is used to enable a exponential tail density of states model for the site 
 		// energies
 		bool Enable_exponential_dos = false;
 		// This parameter defines the shape of exponential tail using the so-called Urbach energy.
 		double Site_energy_urbach = 0.0; // (eV)
 
+		// -----------------------------------------------------------------------------------------------
+		// Storage and Performance Options - These options are set with command line arguments instead of the
+		// parameter file.  The compact and sparse site storage modes and the global BKL engine give results that are
+		// statistically equivalent to, but not identical with, the default settings for the same random seed, while
+		// the other options do not change the simulation results.
+		// -----------------------------------------------------------------------------------------------
+
+		// This option stores the site energies in a contiguous float array and the Boltzmann weights in a contiguous
+		// double array and disables the empty site index to reduce the memory needed for very large lattices.
+		// The hop rates change slightly because the site energies are rounded to single precision, and new excitons
+		// are created by trying random sites instead of drawing from the empty site index.
+		bool Enable_compact_sites = false;
+
+		// This option stores the occupied sites in a hash set and calculates each site energy when it is needed
+		// from a counter-based random number generator, so that no site properties are stored.  The site energies
+		// are the same as with the default storage, but new excitons are created by trying random sites.
+		bool Enable_sparse_sites = false;
+
+		// This option sets the number of threads used by each simulation to create correlated site energies
+		int N_dos_threads = 1;
+
+		// This option enables the global BKL engine, which stores the total event rate of each exciton in a Fenwick
+		// tree and selects the next exciton and its event in O(log N) time instead of ordering the execution times of
+		// all excitons.  The results are statistically equivalent to, but not identical with, the default engine.
+		bool Enable_global_bkl = false;
+
+		// This option enables the event heap scheduler, which stores the execution time of the next event of each exciton
+		// in an indexed binary heap so that the earliest event can be found and an event can be rescheduled or removed
+		// in O(log N) time instead of checking the next events of all excitons
+		bool Enable_event_heap = false;
+
+		// -----------------------------------------------------------------------------------------------
+		// Random Number Options - These options are set with command line arguments instead of the parameter file
+		// -----------------------------------------------------------------------------------------------
+
+		// This option sets the seed of the counter-based random number streams of all simulations, so that the results of
+		// each simulation only depend on the seed and the simulation id.  When it is zero, each simulation draws its seed
+		// from the random number generator of the Simulation base class.
+		uint64_t Random_seed = 0;
+
 	private:
 
 	};
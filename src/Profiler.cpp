@@ -0,0 +1,142 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#include "Profiler.h"
+#include <algorithm>
+#include <string>
+
+using namespace std;
+
+namespace KMC_Lattice_example {
+
+	namespace {
+
+		const string timer_names[] = { "Creation event", "Hop event", "Recombination event", "Neighbor scan", "Rate calculation", "Rate update", "Pathway selection", "Recalculation search" };
+
+		const string phase_names[] = { "Init", "Run", "Gather" };
+
+	}
+
+	constexpr bool Profiler::Enabled;
+	constexpr int Profiler::N_histogram_bins;
+	constexpr int Profiler::N_timers;
+	constexpr int Profiler::N_phases;
+	constexpr int Profiler::N_event_timers;
+
+	void Profiler::lap(const Profile_timer timer, chrono::steady_clock::time_point& time_start) {
+		auto time_end = now();
+		long int time_ns = (long int)chrono::duration_cast<chrono::nanoseconds>(time_end - time_start).count();
+		int index = (int)timer;
+		counts[index]++;
+		times_ns[index] += time_ns;
+		if (index < N_event_timers) {
+			// Determine the histogram bin from the position of the highest set bit
+			int bin = 0;
+			while (bin < N_histogram_bins - 1 && (time_ns >> (bin + 1)) > 0) {
+				bin++;
+			}
+			event_histograms[index][bin]++;
+		}
+		time_start = time_end;
+	}
+
+	void Profiler::addRecalcNeighbors(const long int N_neighbors) {
+		recalc_neighbors.addValue((double)N_neighbors);
+	}
+
+	void Profiler::setPhaseTime(const Profile_phase phase, const double time) {
+		phase_times[(int)phase] = time;
+	}
+
+	void Profiler::merge(const Profiler& other) {
+		for (int i = 0; i < N_timers; i++) {
+			counts[i] += other.counts[i];
+			times_ns[i] += other.times_ns[i];
+		}
+		for (int i = 0; i < N_event_timers; i++) {
+			for (int j = 0; j < N_histogram_bins; j++) {
+				event_histograms[i][j] += other.event_histograms[i][j];
+			}
+		}
+		for (int i = 0; i < N_phases; i++) {
+			phase_times[i] = max(phase_times[i], other.phase_times[i]);
+		}
+		recalc_neighbors.merge(other.recalc_neighbors);
+	}
+
+	long int Profiler::getCount(const Profile_timer timer) const {
+		return counts[(int)timer];
+	}
+
+	double Profiler::getTime(const Profile_timer timer) const {
+		return 1e-9*times_ns[(int)timer];
+	}
+
+	double Profiler::getPhaseTime(const Profile_phase phase) const {
+		return phase_times[(int)phase];
+	}
+
+	void Profiler::writeReport(ostream& stream) const {
+		stream << "Performance profile:\n";
+		for (int i = 0; i < N_phases; i++) {
+			stream << phase_names[i] << " phase time is " << phase_times[i] << " seconds.\n";
+		}
+		long int N_events = 0;
+		for (int i = 0; i < N_event_timers; i++) {
+			N_events += counts[i];
+		}
+		if (phase_times[(int)Profile_phase::Run] > 0) {
+			stream << "Event execution rate is " << N_events / phase_times[(int)Profile_phase::Run] << " events per second.\n";
+		}
+		stream << "Section,Count,Total time (s),Average time (ns)\n";
+		for (int i = 0; i < N_timers; i++) {
+			stream << timer_names[i] << "," << counts[i] << "," << 1e-9*times_ns[i] << "," << (counts[i] > 0 ? (double)times_ns[i] / counts[i] : 0.0) << "\n";
+		}
+		stream << "Neighbors per recalculation is " << recalc_neighbors.getMean() << " +/- " << recalc_neighbors.getStdev() << ".\n";
+		stream << "Event execution time histogram:\n";
+		stream << "Time (ns)," << timer_names[0] << "," << timer_names[1] << "," << timer_names[2] << "\n";
+		// Only the range of bins containing counts is written
+		int bin_min = N_histogram_bins;
+		int bin_max = -1;
+		for (int i = 0; i < N_event_timers; i++) {
+			for (int j = 0; j < N_histogram_bins; j++) {
+				if (event_histograms[i][j] > 0) {
+					bin_min = min(bin_min, j);
+					bin_max = max(bin_max, j);
+				}
+			}
+		}
+		for (int j = bin_min; j <= bin_max; j++) {
+			stream << (1L << j) << "-" << (1L << (j + 1)) << "," << event_histograms[0][j] << "," << event_histograms[1][j] << "," << event_histograms[2][j] << "\n";
+		}
+	}
+
+	Profiler MPI_reduceProfiler(const Profiler& profiler, MPI_Comm comm) {
+		// The counts, times, and histograms are all summed together in one buffer
+		vector<long int> data_in;
+		data_in.insert(data_in.end(), profiler.counts.begin(), profiler.counts.end());
+		data_in.insert(data_in.end(), profiler.times_ns.begin(), profiler.times_ns.end());
+		for (const auto& item : profiler.event_histograms) {
+			data_in.insert(data_in.end(), item.begin(), item.end());
+		}
+		vector<long int> data_out(data_in.size(), 0);
+		MPI_Reduce(data_in.data(), data_out.data(), (int)data_in.size(), MPI_LONG, MPI_SUM, 0, comm);
+		// The phases run concurrently on all processors, so the longest time is used
+		Profiler profiler_total;
+		MPI_Reduce(profiler.phase_times.data(), profiler_total.phase_times.data(), Profiler::N_phases, MPI_DOUBLE, MPI_MAX, 0, comm);
+		profiler_total.recalc_neighbors = MPI_reduceRunningStats(profiler.recalc_neighbors, comm);
+		auto it = data_out.begin();
+		copy(it, it + Profiler::N_timers, profiler_total.counts.begin());
+		it += Profiler::N_timers;
+		copy(it, it + Profiler::N_timers, profiler_total.times_ns.begin());
+		it += Profiler::N_timers;
+		for (auto& item : profiler_total.event_histograms) {
+			copy(it, it + Profiler::N_histogram_bins, item.begin());
+			it += Profiler::N_histogram_bins;
+		}
+		return profiler_total;
+	}
+
+}
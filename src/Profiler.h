@@ -0,0 +1,114 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "Statistics.h"
+#include <mpi.h>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+// The hot path instrumentation is only compiled when ENABLE_PROFILING is defined, which can be done by building with "make PROFILE=1"
+// The PROFILE macro wraps instrumentation statements so that they are removed completely from normal builds.
+#ifdef ENABLE_PROFILING
+#define PROFILE(statement) statement
+#else
+#define PROFILE(statement)
+#endif
+
+namespace KMC_Lattice_example {
+
+	// These are the code sections that are timed by the profiler
+	// The event timers include the time spent recalculating the events of neighboring excitons
+	enum class Profile_timer {
+		Creation_event,
+		Hop_event,
+		Recombination_event,
+		Neighbor_scan,
+		Rate_calculation,
+		Rate_update,
+		Pathway_selection,
+		Recalc_search,
+		Count
+	};
+
+	// These are the phases of the whole program that are timed by the profiler
+	enum class Profile_phase {
+		Init,
+		Run,
+		Gather,
+		Count
+	};
+
+	// This class counts and times the execution of each event type and each phase of the event calculation.
+	// The time spent on each event is also counted in a histogram with bins that double in width so that
+	// the distribution of event execution times can be assessed.
+	class Profiler {
+	public:
+		// Indicates whether the instrumentation was compiled into the program
+#ifdef ENABLE_PROFILING
+		static constexpr bool Enabled = true;
+#else
+		static constexpr bool Enabled = false;
+#endif
+
+		// Number of histogram bins, where bin n counts times from 2^n to 2^(n+1) nanoseconds
+		static constexpr int N_histogram_bins = 40;
+
+		// Gets the current time of the clock used by the profiler
+		static std::chrono::steady_clock::time_point now() {
+			return std::chrono::steady_clock::now();
+		}
+
+		// Adds the time since the specified start time to the specified timer and then resets the start time to the current time
+		void lap(const Profile_timer timer, std::chrono::steady_clock::time_point& time_start);
+
+		// Adds the number of neighboring objects found during one event recalculation search
+		void addRecalcNeighbors(const long int N_neighbors);
+
+		// Sets the wall-clock time in seconds spent in one phase of the program
+		void setPhaseTime(const Profile_phase phase, const double time);
+
+		// Adds the counts and times of another profiler to this profiler
+		// The phase times are combined by taking the maximum since the phases run concurrently.
+		void merge(const Profiler& other);
+
+		// Gets the number of times the specified timer was used
+		long int getCount(const Profile_timer timer) const;
+
+		// Gets the total time in seconds recorded by the specified timer
+		double getTime(const Profile_timer timer) const;
+
+		// Gets the wall-clock time in seconds spent in the specified phase of the program
+		double getPhaseTime(const Profile_phase phase) const;
+
+		// Writes a human readable timing report to the output stream
+		void writeReport(std::ostream& stream) const;
+
+		// Combines the profilers from all processors onto processor 0 using MPI_Reduce
+		friend Profiler MPI_reduceProfiler(const Profiler& profiler, MPI_Comm comm);
+
+	private:
+		static constexpr int N_timers = (int)Profile_timer::Count;
+		static constexpr int N_phases = (int)Profile_phase::Count;
+		// The first timers are the event timers, which also record the execution time histograms
+		static constexpr int N_event_timers = 3;
+		std::array<long int, N_timers> counts = {};
+		std::array<long int, N_timers> times_ns = {};
+		// Histograms of the execution time of each event type
+		std::array<std::array<long int, N_histogram_bins>, N_event_timers> event_histograms = {};
+		std::array<double, N_phases> phase_times = {};
+		Running_stats recalc_neighbors;
+	};
+
+	// Combines the profilers from all processors onto processor 0 using MPI_Reduce
+	Profiler MPI_reduceProfiler(const Profiler& profiler, MPI_Comm comm);
+
+}
+
+#endif // PROFILER_H
@@ -0,0 +1,99 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#include "Progress_monitor.h"
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+namespace KMC_Lattice_example {
+
+	Progress_monitor::Progress_monitor(const long int N_tests_total_in, const double report_interval_in, MPI_Comm comm_in, mutex& mpi_mutex_in) : mpi_mutex(mpi_mutex_in) {
+		N_tests_total = N_tests_total_in;
+		report_interval = report_interval_in;
+		comm = comm_in;
+		MPI_Comm_size(comm, &N_procs);
+		MPI_Comm_rank(comm, &procid);
+		time_reduction_prev = chrono::steady_clock::now();
+		time_report_prev = time_reduction_prev;
+	}
+
+	void Progress_monitor::post(const int replica_id, const int N_recombined, const long int N_events, const double time) {
+		lock_guard<mutex> lock(counters_mutex);
+		counters[replica_id] = { N_recombined, N_events, time };
+	}
+
+	void Progress_monitor::poll() {
+		unique_lock<mutex> lock(mpi_mutex, try_to_lock);
+		if (!lock.owns_lock() || !is_open) {
+			return;
+		}
+		if (request != MPI_REQUEST_NULL) {
+			int is_complete = 0;
+			MPI_Test(&request, &is_complete, MPI_STATUS_IGNORE);
+			if (!is_complete) {
+				return;
+			}
+			report();
+		}
+		if (chrono::duration<double>(chrono::steady_clock::now() - time_reduction_prev).count() >= report_interval) {
+			startReduction(false);
+		}
+	}
+
+	// All processors see the same reduction results, so they all stop after the first reduction that every processor
+	// joined after finishing, and each processor has started the same number of reductions
+	void Progress_monitor::close() {
+		lock_guard<mutex> lock(mpi_mutex);
+		while (is_open) {
+			if (request == MPI_REQUEST_NULL) {
+				startReduction(true);
+			}
+			MPI_Wait(&request, MPI_STATUS_IGNORE);
+			report();
+			if ((int)values_global[4] == N_procs) {
+				is_open = false;
+			}
+		}
+	}
+
+	void Progress_monitor::startReduction(const bool is_finished) {
+		fill(values_local, values_local + N_values, 0.0);
+		{
+			lock_guard<mutex> lock(counters_mutex);
+			for (const auto& item : counters) {
+				values_local[0] += item.second.N_recombined;
+				values_local[1] += item.second.N_events;
+				values_local[2] += item.second.time;
+				values_local[3] += 1;
+			}
+		}
+		values_local[4] = is_finished ? 1 : 0;
+		time_reduction_prev = chrono::steady_clock::now();
+		MPI_Iallreduce(values_local, values_global, N_values, MPI_DOUBLE, MPI_SUM, comm, &request);
+	}
+
+	void Progress_monitor::report() {
+		if (procid != 0) {
+			return;
+		}
+		auto time_now = chrono::steady_clock::now();
+		double elapsed = chrono::duration<double>(time_now - time_report_prev).count();
+		double event_rate = (elapsed > 0) ? (values_global[1] - N_events_prev) / elapsed : 0.0;
+		double test_rate = (elapsed > 0) ? (values_global[0] - N_recombined_prev) / elapsed : 0.0;
+		cout << "Progress: " << (long int)values_global[0] << " of " << N_tests_total << " tests (" << 100.0*values_global[0] / N_tests_total << "%) completed, ";
+		cout << (long int)values_global[1] << " events executed at " << event_rate << " events per second, ";
+		cout << "average simulated time is " << ((values_global[3] > 0) ? values_global[2] / values_global[3] : 0.0) << " seconds";
+		if (values_global[0] < N_tests_total && test_rate > 0) {
+			cout << ", estimated time remaining is " << (N_tests_total - values_global[0]) / test_rate / 60.0 << " minutes";
+		}
+		cout << "." << endl;
+		time_report_prev = time_now;
+		N_recombined_prev = values_global[0];
+		N_events_prev = values_global[1];
+	}
+
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#ifndef PROGRESS_MONITOR_H
+#define PROGRESS_MONITOR_H
+
+#include <mpi.h>
+#include <chrono>
+#include <map>
+#include <mutex>
+
+namespace KMC_Lattice_example {
+
+	// This class periodically combines the progress counters of all simulation replicas on all processors and prints one
+	// progress line with the event rate and the projected time remaining on processor 0.
+	// The counters are combined with non-blocking MPI_Iallreduce operations that are started and tested from the simulation
+	// loop, so the simulations never wait for each other.  Each processor starts a new reduction when the report interval
+	// has passed since it started its previous one, and processor 0 prints the result when all processors have joined it.
+	class Progress_monitor {
+	public:
+		// Constructs the monitor for the specified total number of tests and report interval in seconds of wall-clock time.
+		// All MPI calls of the monitor are made while holding mpi_mutex, which must also be held by any other thread that
+		// makes MPI calls while the simulations are running.
+		Progress_monitor(const long int N_tests_total, const double report_interval, MPI_Comm comm, std::mutex& mpi_mutex);
+
+		// Stores the current counters of the simulation replica with the specified id, which are included in the next reduction
+		void post(const int replica_id, const int N_recombined, const long int N_events, const double time);
+
+		// Tests the reduction in progress and starts a new one when the report interval has passed.  This function never
+		// blocks, and it returns immediately if another thread is making MPI calls.
+		void poll();
+
+		// Completes the reductions until all processors have finished their simulations.  This is a collective operation
+		// that must be called by all processors in the communicator after all of their replicas have finished.
+		void close();
+
+	private:
+		// Counters posted by one simulation replica
+		struct Replica_counters {
+			int N_recombined;
+			long int N_events;
+			double time;
+		};
+
+		long int N_tests_total;
+		double report_interval;
+		MPI_Comm comm;
+		int N_procs = 1;
+		int procid = 0;
+		std::mutex& mpi_mutex;
+
+		// Latest counters of the replicas on this processor
+		std::map<int, Replica_counters> counters;
+		std::mutex counters_mutex;
+
+		// Reduction buffers, which hold the number of recombined excitons, the number of executed events, the sum of the
+		// simulated times, the number of replicas, and the number of finished processors
+		static constexpr int N_values = 5;
+		double values_local[N_values];
+		double values_global[N_values];
+		MPI_Request request = MPI_REQUEST_NULL;
+		bool is_open = true;
+
+		// Wall-clock times of the start of the last reduction and of the last report, and the global counters at the last
+		// report, which are used to calculate the rates
+		std::chrono::steady_clock::time_point time_reduction_prev;
+		std::chrono::steady_clock::time_point time_report_prev;
+		double N_recombined_prev = 0;
+		double N_events_prev = 0;
+
+		// Starts a new reduction with the current counters of this processor
+		void startReduction(const bool is_finished);
+
+		// Prints the progress line for the completed reduction on processor 0
+		void report();
+	};
+
+}
+
+#endif // PROGRESS_MONITOR_H
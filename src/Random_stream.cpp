@@ -0,0 +1,111 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#include "Random_stream.h"
+
+namespace KMC_Lattice_example {
+
+	namespace {
+
+		// Multipliers and key increments of the Philox4x32 rounds
+		const uint64_t Philox_m0 = 0xD2511F53ULL;
+		const uint64_t Philox_m1 = 0xCD9E8D57ULL;
+		const uint32_t Philox_w0 = 0x9E3779B9U;
+		const uint32_t Philox_w1 = 0xBB67AE85U;
+
+		// Applies the ten rounds of the Philox4x32 bijection to the counter with the specified key
+		inline void calculatePhilox(uint32_t counter[4], uint32_t key0, uint32_t key1) {
+			for (int round = 0; round < 10; round++) {
+				const uint64_t product0 = Philox_m0 * counter[0];
+				const uint64_t product1 = Philox_m1 * counter[2];
+				const uint32_t hi0 = (uint32_t)(product0 >> 32);
+				const uint32_t hi1 = (uint32_t)(product1 >> 32);
+				counter[0] = hi1 ^ counter[1] ^ key0;
+				counter[1] = (uint32_t)product1;
+				counter[2] = hi0 ^ counter[3] ^ key1;
+				counter[3] = (uint32_t)product0;
+				key0 += Philox_w0;
+				key1 += Philox_w1;
+			}
+		}
+
+		// Converts the upper 53 bits of a 64-bit output to a uniform random number in the interval [0,1)
+		inline double convertToUniform(const uint64_t output) {
+			return (output >> 11) * (1.0 / 9007199254740992.0);
+		}
+
+	}
+
+	Random_stream::Random_stream(const uint64_t seed, const uint32_t replica_id_in, const uint32_t purpose_id_in) {
+		key[0] = (uint32_t)seed;
+		key[1] = (uint32_t)(seed >> 32);
+		replica_id = replica_id_in;
+		purpose_id = purpose_id_in;
+	}
+
+	Random_stream::result_type Random_stream::operator()() {
+		const uint64_t block_index = position >> 1;
+		if (block_index != block_cached) {
+			calculateBlock(block_index, outputs_cached);
+			block_cached = block_index;
+		}
+		return outputs_cached[position++ & 1];
+	}
+
+	void Random_stream::discard(const uint64_t N_outputs) {
+		position += N_outputs;
+	}
+
+	double Random_stream::getUniform(const uint64_t index) const {
+		uint64_t outputs[2];
+		calculateBlock(index >> 1, outputs);
+		return convertToUniform(outputs[index & 1]);
+	}
+
+	double Random_stream::generateUniform() {
+		return convertToUniform((*this)());
+	}
+
+	// The random numbers that fill whole blocks are calculated directly, and the first and last numbers are taken from
+	// the cached block when the batch does not start or end on a block boundary
+	void Random_stream::generateUniforms(double* values, const int N) {
+		int i = 0;
+		if (N > 0 && (position & 1)) {
+			values[i++] = generateUniform();
+		}
+		const int N_blocks = (N - i) / 2;
+		const uint64_t block_first = position >> 1;
+		const uint32_t key0 = key[0];
+		const uint32_t key1 = key[1];
+		for (int n = 0; n < N_blocks; n++) {
+			const uint64_t block_index = block_first + n;
+			uint32_t counter[4] = { (uint32_t)block_index, (uint32_t)(block_index >> 32), replica_id, purpose_id };
+			calculatePhilox(counter, key0, key1);
+			values[i + 2 * n] = convertToUniform(((uint64_t)counter[1] << 32) | counter[0]);
+			values[i + 2 * n + 1] = convertToUniform(((uint64_t)counter[3] << 32) | counter[2]);
+		}
+		position += 2 * (uint64_t)N_blocks;
+		for (i += 2 * N_blocks; i < N; i++) {
+			values[i] = generateUniform();
+		}
+	}
+
+	uint64_t Random_stream::getPosition() const {
+		return position;
+	}
+
+	void Random_stream::setPosition(const uint64_t position_in) {
+		position = position_in;
+	}
+
+	// The 128-bit counter of each block is made of the 64-bit block index, the replica id, and the purpose id
+	void Random_stream::calculateBlock(const uint64_t block_index, uint64_t outputs[2]) const {
+		uint32_t counter[4] = { (uint32_t)block_index, (uint32_t)(block_index >> 32), replica_id, purpose_id };
+		calculatePhilox(counter, key[0], key[1]);
+		outputs[0] = ((uint64_t)counter[1] << 32) | counter[0];
+		outputs[1] = ((uint64_t)counter[3] << 32) | counter[2];
+	}
+
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#ifndef RANDOM_STREAM_H
+#define RANDOM_STREAM_H
+
+#include <cstdint>
+
+namespace KMC_Lattice_example {
+
+	// This class is a counter-based random number generator that uses the Philox4x32-10 bijection of Salmon et al.
+	// (SC11, 2011).  Each stream is identified by a 64-bit seed, a replica id, and a purpose id, and the n-th 64-bit
+	// output of a stream is calculated directly from these values and n.  Therefore, the state of a stream is only its
+	// position, a stream can be moved to any position in O(1) time, and streams with different replica or purpose ids are
+	// independent, so the random numbers used by a replica do not depend on how the replicas are distributed between
+	// processors and threads.
+	// The class meets the requirements of a uniform random bit generator, so it can also be used with the standard
+	// random number distributions.  Fixed-width integer types are used for the seed, counter, and outputs, so that a
+	// stream gives the same numbers on platforms where long int only has 32 bits.
+	class Random_stream {
+	public:
+		typedef uint64_t result_type;
+
+		// Constructs a stream with a zero seed, replica id, and purpose id
+		Random_stream() {}
+
+		// Constructs the stream with the specified seed, replica id, and purpose id that starts at position zero
+		Random_stream(const uint64_t seed, const uint32_t replica_id, const uint32_t purpose_id);
+
+		// Gets the smallest and largest possible outputs
+		static constexpr result_type min() { return 0; }
+		static constexpr result_type max() { return UINT64_MAX; }
+
+		// Gets the next 64-bit output of the stream
+		result_type operator()();
+
+		// Advances the stream by the specified number of outputs in O(1) time
+		void discard(const uint64_t N_outputs);
+
+		// Gets the uniform random number in the interval [0,1) that is created from the output at the specified position,
+		// which does not change the position of the stream
+		double getUniform(const uint64_t index) const;
+
+		// Gets the next uniform random number in the interval [0,1)
+		double generateUniform();
+
+		// Fills the array with the next N uniform random numbers in the interval [0,1), which gives the same numbers as
+		// N calls of generateUniform.  The outputs are calculated in a loop without dependencies between iterations, so
+		// that the compiler can vectorize it.
+		void generateUniforms(double* values, const int N);
+
+		// Gets the number of outputs that have been used since the start of the stream
+		uint64_t getPosition() const;
+
+		// Moves the stream to the specified position in O(1) time
+		void setPosition(const uint64_t position);
+
+	private:
+		uint32_t key[2] = { 0, 0 };
+		uint32_t replica_id = 0;
+		uint32_t purpose_id = 0;
+		uint64_t position = 0;
+		// Each Philox block gives two 64-bit outputs, so the last calculated block is kept for the next output
+		uint64_t block_cached = UINT64_MAX;
+		uint64_t outputs_cached[2] = { 0, 0 };
+
+		// Calculates the two 64-bit outputs of the block with the specified index
+		void calculateBlock(const uint64_t block_index, uint64_t outputs[2]) const;
+	};
+
+}
+
+#endif // RANDOM_STREAM_H
@@ -0,0 +1,121 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#include "Rate_tree.h"
+#include "Binary_io.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace KMC_Lattice_example {
+
+	void Rate_tree::clear() {
+		rates.clear();
+		partial_sums.clear();
+		N_updates = 0;
+	}
+
+	double Rate_tree::getRate(const int index) const {
+		return (index < (int)rates.size()) ? rates[index] : 0.0;
+	}
+
+	// The capacity is always a power of two, so the last partial sum is the sum of all rates
+	double Rate_tree::getTotal() const {
+		return rates.empty() ? 0.0 : max(partial_sums.back(), 0.0);
+	}
+
+	void Rate_tree::setRate(const int index, const double rate) {
+		int capacity = (int)rates.size();
+		if (index >= capacity) {
+			capacity = max(capacity, 16);
+			while (capacity <= index) {
+				capacity *= 2;
+			}
+			rates.resize(capacity, 0.0);
+			rates[index] = rate;
+			rebuild();
+			return;
+		}
+		const double delta = rate - rates[index];
+		rates[index] = rate;
+		for (int i = index + 1; i <= capacity; i += i & (-i)) {
+			partial_sums[i] += delta;
+		}
+		// Rebuilding after every N changes keeps the rounding errors bounded at an amortized cost of O(1) per change
+		N_updates++;
+		if (N_updates >= capacity) {
+			rebuild();
+		}
+	}
+
+	// The capacity is the smallest power of two, but at least 16, that holds all rates, as in setRate
+	void Rate_tree::setRates(const double* rates_in, const int N) {
+		int capacity = 16;
+		while (capacity < N) {
+			capacity *= 2;
+		}
+		rates.assign(capacity, 0.0);
+		copy(rates_in, rates_in + N, rates.begin());
+		rebuild();
+	}
+
+	int Rate_tree::findIndex(const double rate_target) const {
+		if (!(getTotal() > 0)) {
+			return -1;
+		}
+		// Descend the tree to find the number of rates whose cumulative sum is not greater than the target
+		const int capacity = (int)rates.size();
+		int position = 0;
+		double remainder = rate_target;
+		for (int step = capacity; step > 0; step >>= 1) {
+			if (position + step <= capacity && !(remainder < partial_sums[position + step])) {
+				position += step;
+				remainder -= partial_sums[position];
+			}
+		}
+		// Rounding errors can place a target at the very end of the range past the last nonzero rate
+		if (position < capacity && rates[position] > 0) {
+			return position;
+		}
+		for (int i = min(position, capacity - 1); i >= 0; i--) {
+			if (rates[i] > 0) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	void Rate_tree::writeBinary(ostream& stream) const {
+		writeBinaryVector(stream, rates);
+		writeBinaryVector(stream, partial_sums);
+		KMC_Lattice_example::writeBinary(stream, N_updates);
+	}
+
+	// The capacity must be a power of two with one more partial sum than rates, as created by setRate and setRates
+	bool Rate_tree::readBinary(istream& stream) {
+		if (!readBinaryVector(stream, rates) || !readBinaryVector(stream, partial_sums) || !KMC_Lattice_example::readBinary(stream, N_updates)) {
+			return false;
+		}
+		const size_t capacity = rates.size();
+		if (capacity == 0) {
+			return partial_sums.empty();
+		}
+		return (capacity & (capacity - 1)) == 0 && partial_sums.size() == capacity + 1 && N_updates >= 0 && N_updates < (long int)capacity;
+	}
+
+	void Rate_tree::rebuild() {
+		const int capacity = (int)rates.size();
+		partial_sums.assign(capacity + 1, 0.0);
+		for (int i = 1; i <= capacity; i++) {
+			partial_sums[i] += rates[i - 1];
+			int parent = i + (i & (-i));
+			if (parent <= capacity) {
+				partial_sums[parent] += partial_sums[i];
+			}
+		}
+		N_updates = 0;
+	}
+
+}
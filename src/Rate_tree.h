@@ -0,0 +1,64 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#ifndef RATE_TREE_H
+#define RATE_TREE_H
+
+#include <iostream>
+#include <vector>
+
+namespace KMC_Lattice_example {
+
+	// This class stores a list of non-negative rates in a Fenwick tree (binary indexed tree), so that the total rate
+	// can be calculated, a single rate can be changed, and an index can be selected with probability proportional to
+	// its rate in O(log N) time.
+	// Changes are applied as differences to the partial sums, so the tree is periodically rebuilt from the stored rates
+	// to keep rounding errors from accumulating.
+	class Rate_tree {
+	public:
+		// Constructs an empty tree
+		Rate_tree() {}
+
+		// Removes all rates from the tree
+		void clear();
+
+		// Gets the rate with the specified index, which is zero for indices that have not been set
+		double getRate(const int index) const;
+
+		// Gets the sum of all rates
+		double getTotal() const;
+
+		// Sets the rate with the specified index, where the tree grows as needed to hold the index
+		void setRate(const int index, const double rate);
+
+		// Replaces all rates with the N specified rates and rebuilds the tree in O(N) time
+		void setRates(const double* rates_in, const int N);
+
+		// Finds the index whose range of the cumulative rates contains the specified target value, which must be in
+		// the range [0, getTotal()).  When a uniform random target is used, each index is selected with a probability
+		// proportional to its rate.  Indices with zero rates are never selected, and -1 is returned if all rates are zero.
+		int findIndex(const double rate_target) const;
+
+		// Writes the rates, partial sums, and rebuild counter to a binary stream, so that a restored tree gives exactly the same
+		// totals and selections as the original tree
+		void writeBinary(std::ostream& stream) const;
+
+		// Reads the tree from a binary stream and returns false if an error occurs
+		bool readBinary(std::istream& stream);
+
+	private:
+		// The rates and the partial sums of the Fenwick tree, which use one-based indices internally
+		std::vector<double> rates;
+		std::vector<double> partial_sums;
+		// Number of rate changes since the partial sums were last rebuilt
+		long int N_updates = 0;
+
+		// Recalculates all partial sums from the rates in O(N) time
+		void rebuild();
+	};
+
+}
+
+#endif // RATE_TREE_H
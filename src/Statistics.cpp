@@ -0,0 +1,393 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#include "Statistics.h"
+#include "Binary_io.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace KMC_Lattice_example {
+
+	Running_stats::Running_stats(const long int count_in, const double mean_in, const double m2_in) {
+		count = count_in;
+		mean = mean_in;
+		m2 = m2_in;
+	}
+
+	void Running_stats::addValue(const double value) {
+		count++;
+		double delta = value - mean;
+		mean += delta / count;
+		m2 += delta * (value - mean);
+	}
+
+	// Uses the pairwise update formula of Chan et al. to combine the statistics
+	void Running_stats::merge(const Running_stats& other) {
+		if (other.count == 0) {
+			return;
+		}
+		if (count == 0) {
+			*this = other;
+			return;
+		}
+		long int count_total = count + other.count;
+		double delta = other.mean - mean;
+		mean += delta * other.count / count_total;
+		m2 += other.m2 + delta * delta * ((double)count * other.count / count_total);
+		count = count_total;
+	}
+
+	long int Running_stats::getCount() const {
+		return count;
+	}
+
+	double Running_stats::getMean() const {
+		return mean;
+	}
+
+	double Running_stats::getM2() const {
+		return m2;
+	}
+
+	double Running_stats::getStdev() const {
+		if (count < 2) {
+			return 0.0;
+		}
+		return sqrt(m2 / (count - 1));
+	}
+
+	void Running_stats::writeBinary(ostream& stream) const {
+		KMC_Lattice_example::writeBinary(stream, count);
+		KMC_Lattice_example::writeBinary(stream, mean);
+		KMC_Lattice_example::writeBinary(stream, m2);
+	}
+
+	bool Running_stats::readBinary(istream& stream) {
+		return KMC_Lattice_example::readBinary(stream, count) && KMC_Lattice_example::readBinary(stream, mean) && KMC_Lattice_example::readBinary(stream, m2);
+	}
+
+	Histogram::Histogram(const double bin_size_in, const int N_bins) {
+		if (!(bin_size_in > 0) || N_bins < 0) {
+			throw invalid_argument("Error! The histogram bin size must be greater than zero and the number of bins cannot be negative.");
+		}
+		bin_size = bin_size_in;
+		counts.assign(N_bins, 0);
+	}
+
+	Histogram::Histogram(const double bin_size_in, const vector<long int>& counts_in, const long int overflow_count_in) : Histogram(bin_size_in, 0) {
+		counts = counts_in;
+		overflow_count = overflow_count_in;
+	}
+
+	void Histogram::addValue(const double value) {
+		double bin = floor(value / bin_size);
+		if (bin >= 0 && bin < (double)counts.size()) {
+			counts[(int)bin]++;
+		}
+		else {
+			overflow_count++;
+		}
+	}
+
+	void Histogram::merge(const Histogram& other) {
+		if (other.counts.size() != counts.size() || other.bin_size != bin_size) {
+			throw invalid_argument("Error! Histograms with different bins cannot be merged.");
+		}
+		for (int i = 0; i < (int)counts.size(); i++) {
+			counts[i] += other.counts[i];
+		}
+		overflow_count += other.overflow_count;
+	}
+
+	double Histogram::getBinSize() const {
+		return bin_size;
+	}
+
+	const vector<long int>& Histogram::getCounts() const {
+		return counts;
+	}
+
+	long int Histogram::getOverflowCount() const {
+		return overflow_count;
+	}
+
+	void Histogram::writeBinary(ostream& stream) const {
+		KMC_Lattice_example::writeBinary(stream, bin_size);
+		writeBinaryVector(stream, counts);
+		KMC_Lattice_example::writeBinary(stream, overflow_count);
+	}
+
+	bool Histogram::readBinary(istream& stream) {
+		return KMC_Lattice_example::readBinary(stream, bin_size) && readBinaryVector(stream, counts) && KMC_Lattice_example::readBinary(stream, overflow_count);
+	}
+
+	Reservoir_sample::Reservoir_sample(const int capacity_in, const unsigned long int seed) {
+		if (capacity_in < 0) {
+			throw invalid_argument("Error! The reservoir sample capacity cannot be negative.");
+		}
+		capacity = capacity_in;
+		sample.reserve(capacity);
+		generator.seed(seed);
+	}
+
+	Reservoir_sample::Reservoir_sample(const int capacity_in, const long int N_values_in, const vector<double>& sample_in, const unsigned long int seed) : Reservoir_sample(capacity_in, seed) {
+		if ((int)sample_in.size() > capacity || (long int)sample_in.size() > N_values_in) {
+			throw invalid_argument("Error! The reservoir sample cannot contain more values than its capacity or its data stream.");
+		}
+		N_values = N_values_in;
+		sample = sample_in;
+	}
+
+	void Reservoir_sample::addValue(const double value) {
+		N_values++;
+		if ((int)sample.size() < capacity) {
+			sample.push_back(value);
+			return;
+		}
+		if (capacity == 0) {
+			return;
+		}
+		// Replace a random value so that each value offered so far has the same probability of being in the sample
+		uniform_int_distribution<long int> distn(0, N_values - 1);
+		long int index = distn(generator);
+		if (index < capacity) {
+			sample[index] = value;
+		}
+	}
+
+	// The values of the merged sample are drawn one at a time from the two data streams without replacement,
+	// so the number of values taken from each sample follows the hypergeometric distribution
+	void Reservoir_sample::merge(const Reservoir_sample& other) {
+		vector<double> sample_a = sample;
+		vector<double> sample_b = other.sample;
+		shuffle(sample_a.begin(), sample_a.end(), generator);
+		shuffle(sample_b.begin(), sample_b.end(), generator);
+		long int population_a = N_values;
+		long int population_b = other.N_values;
+		sample.clear();
+		while ((int)sample.size() < capacity && (population_a + population_b) > 0) {
+			uniform_int_distribution<long int> distn(0, population_a + population_b - 1);
+			bool use_a = distn(generator) < population_a;
+			auto& source = use_a ? sample_a : sample_b;
+			if (source.empty()) {
+				break;
+			}
+			sample.push_back(source.back());
+			source.pop_back();
+			(use_a ? population_a : population_b)--;
+		}
+		N_values += other.N_values;
+	}
+
+	int Reservoir_sample::getCapacity() const {
+		return capacity;
+	}
+
+	long int Reservoir_sample::getN_values() const {
+		return N_values;
+	}
+
+	const vector<double>& Reservoir_sample::getSample() const {
+		return sample;
+	}
+
+	void Reservoir_sample::writeBinary(ostream& stream) const {
+		KMC_Lattice_example::writeBinary(stream, capacity);
+		KMC_Lattice_example::writeBinary(stream, N_values);
+		writeBinaryVector(stream, sample);
+		writeGeneratorState(stream, generator);
+	}
+
+	bool Reservoir_sample::readBinary(istream& stream) {
+		return KMC_Lattice_example::readBinary(stream, capacity) && KMC_Lattice_example::readBinary(stream, N_values) && readBinaryVector(stream, sample) && readGeneratorState(stream, generator);
+	}
+
+	namespace {
+
+		// MPI user function that merges running statistics stored as {count, mean, m2} triplets
+		void mergeRunningStats(void* in, void* inout, int* len, MPI_Datatype*) {
+			double* data_in = static_cast<double*>(in);
+			double* data_inout = static_cast<double*>(inout);
+			for (int i = 0; i < *len; i++) {
+				Running_stats stats_in((long int)data_in[3 * i], data_in[3 * i + 1], data_in[3 * i + 2]);
+				Running_stats stats_inout((long int)data_inout[3 * i], data_inout[3 * i + 1], data_inout[3 * i + 2]);
+				stats_inout.merge(stats_in);
+				data_inout[3 * i] = (double)stats_inout.getCount();
+				data_inout[3 * i + 1] = stats_inout.getMean();
+				data_inout[3 * i + 2] = stats_inout.getM2();
+			}
+		}
+
+	}
+
+	Time_binned_msd::Time_binned_msd(const double time_min_in, const double time_max, const int bins_per_decade_in) {
+		if (!(time_min_in > 0) || !(time_max > time_min_in) || bins_per_decade_in < 1) {
+			throw invalid_argument("Error! The mean squared displacement time range must be positive and the number of bins per decade must be at least one.");
+		}
+		time_min = time_min_in;
+		bins_per_decade = bins_per_decade_in;
+		int N_bins = 1 + (int)ceil(bins_per_decade*log10(time_max / time_min) - 1e-9);
+		weights.assign(N_bins, 0.0);
+		sums.assign(N_bins, 0.0);
+	}
+
+	Time_binned_msd::Time_binned_msd(const double time_min_in, const int bins_per_decade_in, const vector<double>& weights_in, const vector<double>& sums_in) {
+		if (weights_in.size() != sums_in.size()) {
+			throw invalid_argument("Error! The mean squared displacement weights and sums must have the same number of bins.");
+		}
+		time_min = time_min_in;
+		bins_per_decade = bins_per_decade_in;
+		weights = weights_in;
+		sums = sums_in;
+	}
+
+	void Time_binned_msd::addInterval(const double time_start, const double time_end, const double squared_displacement) {
+		const int N_bins = (int)weights.size();
+		for (int bin = findBin(time_start); bin < N_bins && getBinStart(bin) < time_end; bin++) {
+			double overlap = min(time_end, getBinEnd(bin)) - max(time_start, getBinStart(bin));
+			if (overlap > 0) {
+				weights[bin] += overlap;
+				sums[bin] += overlap * squared_displacement;
+			}
+		}
+	}
+
+	void Time_binned_msd::merge(const Time_binned_msd& other) {
+		if (other.weights.size() != weights.size() || other.time_min != time_min || other.bins_per_decade != bins_per_decade) {
+			throw invalid_argument("Error! Mean squared displacement accumulators with different bins cannot be merged.");
+		}
+		for (int i = 0; i < (int)weights.size(); i++) {
+			weights[i] += other.weights[i];
+			sums[i] += other.sums[i];
+		}
+	}
+
+	int Time_binned_msd::getN_bins() const {
+		return (int)weights.size();
+	}
+
+	double Time_binned_msd::getBinStart(const int bin) const {
+		return (bin == 0) ? 0.0 : time_min * pow(10.0, (double)(bin - 1) / bins_per_decade);
+	}
+
+	double Time_binned_msd::getBinEnd(const int bin) const {
+		return time_min * pow(10.0, (double)bin / bins_per_decade);
+	}
+
+	double Time_binned_msd::getMsd(const int bin) const {
+		return (weights[bin] > 0) ? sums[bin] / weights[bin] : 0.0;
+	}
+
+	const vector<double>& Time_binned_msd::getWeights() const {
+		return weights;
+	}
+
+	const vector<double>& Time_binned_msd::getSums() const {
+		return sums;
+	}
+
+	double Time_binned_msd::getTimeMin() const {
+		return time_min;
+	}
+
+	int Time_binned_msd::getBinsPerDecade() const {
+		return bins_per_decade;
+	}
+
+	void Time_binned_msd::writeBinary(ostream& stream) const {
+		KMC_Lattice_example::writeBinary(stream, time_min);
+		KMC_Lattice_example::writeBinary(stream, bins_per_decade);
+		writeBinaryVector(stream, weights);
+		writeBinaryVector(stream, sums);
+	}
+
+	bool Time_binned_msd::readBinary(istream& stream) {
+		return KMC_Lattice_example::readBinary(stream, time_min) && KMC_Lattice_example::readBinary(stream, bins_per_decade) && readBinaryVector(stream, weights) && readBinaryVector(stream, sums) && weights.size() == sums.size();
+	}
+
+	// The logarithm can be rounded across a bin edge, so the bin is corrected using the exact bin start time
+	int Time_binned_msd::findBin(const double time) const {
+		if (time < time_min) {
+			return 0;
+		}
+		int bin = 1 + (int)floor(bins_per_decade*log10(time / time_min));
+		if (bin > 1 && time < getBinStart(bin)) {
+			bin--;
+		}
+		return bin;
+	}
+
+	Running_stats MPI_reduceRunningStats(const Running_stats& stats, MPI_Comm comm) {
+		MPI_Datatype stats_type;
+		MPI_Type_contiguous(3, MPI_DOUBLE, &stats_type);
+		MPI_Type_commit(&stats_type);
+		MPI_Op merge_op;
+		MPI_Op_create(&mergeRunningStats, 1, &merge_op);
+		double data_in[3] = { (double)stats.getCount(), stats.getMean(), stats.getM2() };
+		double data_out[3] = { 0.0, 0.0, 0.0 };
+		MPI_Reduce(data_in, data_out, 1, stats_type, merge_op, 0, comm);
+		MPI_Op_free(&merge_op);
+		MPI_Type_free(&stats_type);
+		return Running_stats((long int)data_out[0], data_out[1], data_out[2]);
+	}
+
+	Histogram MPI_reduceHistogram(const Histogram& histogram, MPI_Comm comm) {
+		// The overflow count is reduced together with the bin counts as the last element
+		vector<long int> data_in = histogram.getCounts();
+		data_in.push_back(histogram.getOverflowCount());
+		vector<long int> data_out(data_in.size(), 0);
+		MPI_Reduce(data_in.data(), data_out.data(), (int)data_in.size(), MPI_LONG, MPI_SUM, 0, comm);
+		long int overflow_count = data_out.back();
+		data_out.pop_back();
+		return Histogram(histogram.getBinSize(), data_out, overflow_count);
+	}
+
+	Time_binned_msd MPI_reduceTimeBinnedMsd(const Time_binned_msd& msd, MPI_Comm comm) {
+		// The weights and sums are reduced together in one array
+		vector<double> data_in = msd.getWeights();
+		data_in.insert(data_in.end(), msd.getSums().begin(), msd.getSums().end());
+		vector<double> data_out(data_in.size(), 0.0);
+		MPI_Reduce(data_in.data(), data_out.data(), (int)data_in.size(), MPI_DOUBLE, MPI_SUM, 0, comm);
+		const int N_bins = msd.getN_bins();
+		vector<double> weights(data_out.begin(), data_out.begin() + N_bins);
+		vector<double> sums(data_out.begin() + N_bins, data_out.end());
+		return Time_binned_msd(msd.getTimeMin(), msd.getBinsPerDecade(), weights, sums);
+	}
+
+	Reservoir_sample MPI_reduceReservoirSample(const Reservoir_sample& sample, MPI_Comm comm) {
+		int nproc = 1;
+		int procid = 0;
+		MPI_Comm_size(comm, &nproc);
+		MPI_Comm_rank(comm, &procid);
+		// Gather the number of values represented by each sample and the sample sizes
+		long int N_values = sample.getN_values();
+		int sample_size = (int)sample.getSample().size();
+		vector<long int> N_values_all(nproc, 0);
+		vector<int> sample_sizes(nproc, 0);
+		MPI_Gather(&N_values, 1, MPI_LONG, N_values_all.data(), 1, MPI_LONG, 0, comm);
+		MPI_Gather(&sample_size, 1, MPI_INT, sample_sizes.data(), 1, MPI_INT, 0, comm);
+		// Gather the sample values
+		vector<int> displacements(nproc, 0);
+		for (int i = 1; i < nproc; i++) {
+			displacements[i] = displacements[i - 1] + sample_sizes[i - 1];
+		}
+		vector<double> values_all(procid == 0 ? displacements[nproc - 1] + sample_sizes[nproc - 1] : 0);
+		MPI_Gatherv(sample.getSample().data(), sample_size, MPI_DOUBLE, values_all.data(), sample_sizes.data(), displacements.data(), MPI_DOUBLE, 0, comm);
+		if (procid != 0) {
+			return sample;
+		}
+		// Merge the samples from all processors on processor 0
+		Reservoir_sample sample_total = sample;
+		for (int i = 1; i < nproc; i++) {
+			vector<double> values(values_all.begin() + displacements[i], values_all.begin() + displacements[i] + sample_sizes[i]);
+			sample_total.merge(Reservoir_sample(sample.getCapacity(), N_values_all[i], values, 0));
+		}
+		return sample_total;
+	}
+
+}
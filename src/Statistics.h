@@ -0,0 +1,216 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <mpi.h>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace KMC_Lattice_example {
+
+	// This class accumulates the count, mean, and variance of a stream of values using Welford's online
+	// algorithm, so that the statistics can be calculated without storing the values.
+	class Running_stats {
+	public:
+		// Constructs empty statistics
+		Running_stats() {}
+
+		// Constructs statistics from a count, mean, and sum of squared deviations from the mean
+		Running_stats(const long int count, const double mean, const double m2);
+
+		// Adds a new value to the statistics
+		void addValue(const double value);
+
+		// Combines the statistics of another data stream with these statistics
+		void merge(const Running_stats& other);
+
+		// Gets the number of values that have been added
+		long int getCount() const;
+
+		// Gets the mean of all values that have been added
+		double getMean() const;
+
+		// Gets the sum of the squared deviations from the mean of all values that have been added
+		double getM2() const;
+
+		// Gets the sample standard deviation of all values that have been added
+		double getStdev() const;
+
+		// Writes the statistics to a binary stream
+		void writeBinary(std::ostream& stream) const;
+
+		// Reads the statistics from a binary stream and returns false if an error occurs
+		bool readBinary(std::istream& stream);
+
+	private:
+		long int count = 0;
+		double mean = 0.0;
+		// Sum of the squared deviations from the mean
+		double m2 = 0.0;
+	};
+
+	// This class counts a stream of values in fixed-width bins starting from zero.
+	// Values that are beyond the last bin are counted separately as overflow.
+	class Histogram {
+	public:
+		// Constructs an empty histogram with no bins
+		Histogram() {}
+
+		// Constructs an empty histogram with the specified bin width and number of bins
+		Histogram(const double bin_size, const int N_bins);
+
+		// Constructs a histogram with the specified bin width, bin counts, and overflow count
+		Histogram(const double bin_size, const std::vector<long int>& counts, const long int overflow_count);
+
+		// Adds a new value to the histogram
+		void addValue(const double value);
+
+		// Adds the counts of another histogram with the same bins to this histogram
+		void merge(const Histogram& other);
+
+		// Gets the width of each bin
+		double getBinSize() const;
+
+		// Gets the count in each bin
+		const std::vector<long int>& getCounts() const;
+
+		// Gets the number of values that were beyond the last bin
+		long int getOverflowCount() const;
+
+		// Writes the histogram to a binary stream
+		void writeBinary(std::ostream& stream) const;
+
+		// Reads the histogram from a binary stream and returns false if an error occurs
+		bool readBinary(std::istream& stream);
+
+	private:
+		double bin_size = 1.0;
+		std::vector<long int> counts;
+		long int overflow_count = 0;
+	};
+
+	// This class keeps a fixed-size uniform random sample of a stream of values using the reservoir sampling
+	// algorithm.  It uses its own random number generator so that sampling does not affect the simulation.
+	class Reservoir_sample {
+	public:
+		// Constructs an empty sample that does not store any values
+		Reservoir_sample() {}
+
+		// Constructs an empty sample that will store at most capacity values
+		Reservoir_sample(const int capacity, const unsigned long int seed);
+
+		// Constructs a sample that already contains the specified values, which were drawn from a data
+		// stream of N_values values
+		Reservoir_sample(const int capacity, const long int N_values, const std::vector<double>& sample, const unsigned long int seed);
+
+		// Offers a new value to the sample
+		void addValue(const double value);
+
+		// Combines another sample with this one so that the result is a uniform sample of both data streams
+		void merge(const Reservoir_sample& other);
+
+		// Gets the maximum number of values stored in the sample
+		int getCapacity() const;
+
+		// Gets the number of values that have been offered to the sample
+		long int getN_values() const;
+
+		// Gets the values that are currently in the sample
+		const std::vector<double>& getSample() const;
+
+		// Writes the sample and the state of its random number generator to a binary stream
+		void writeBinary(std::ostream& stream) const;
+
+		// Reads the sample and the state of its random number generator from a binary stream and returns
+		// false if an error occurs
+		bool readBinary(std::istream& stream);
+
+	private:
+		int capacity = 0;
+		long int N_values = 0;
+		std::vector<double> sample;
+		std::mt19937_64 generator;
+	};
+
+	// This class accumulates the mean squared displacement of objects as a function of the time since their creation in
+	// logarithmically spaced time bins.  The first bin covers the times from zero to time_min, and the following bins have
+	// bins_per_decade bins per decade up to at least time_max.  Times beyond the last bin are not counted.
+	// The squared displacement of an object is constant between its events, so each time interval is added to every bin
+	// that it overlaps, weighted by the overlap duration.  The mean squared displacement in each bin is then the time average
+	// over all objects that existed during the bin.
+	class Time_binned_msd {
+	public:
+		// Constructs an empty accumulator with no bins
+		Time_binned_msd() {}
+
+		// Constructs an empty accumulator with the specified time range and bin density
+		Time_binned_msd(const double time_min, const double time_max, const int bins_per_decade);
+
+		// Constructs an accumulator with the specified bins and the weights and weighted sums of the squared displacements
+		Time_binned_msd(const double time_min, const int bins_per_decade, const std::vector<double>& weights, const std::vector<double>& sums);
+
+		// Adds a time interval since the creation of an object during which it had the specified squared displacement
+		void addInterval(const double time_start, const double time_end, const double squared_displacement);
+
+		// Adds the data of another accumulator with the same bins to this accumulator
+		void merge(const Time_binned_msd& other);
+
+		// Gets the number of bins
+		int getN_bins() const;
+
+		// Gets the start and end times of the specified bin
+		double getBinStart(const int bin) const;
+		double getBinEnd(const int bin) const;
+
+		// Gets the mean squared displacement in the specified bin, which is zero if no data was added to the bin
+		double getMsd(const int bin) const;
+
+		// Gets the total object time in each bin, which is the sum of the overlap durations of all intervals
+		const std::vector<double>& getWeights() const;
+
+		// Gets the sum of the squared displacements weighted by the overlap durations in each bin
+		const std::vector<double>& getSums() const;
+
+		// Gets the time that separates the first bin from the logarithmic bins and the number of bins per decade
+		double getTimeMin() const;
+		int getBinsPerDecade() const;
+
+		// Writes the accumulator to a binary stream
+		void writeBinary(std::ostream& stream) const;
+
+		// Reads the accumulator from a binary stream and returns false if an error occurs
+		bool readBinary(std::istream& stream);
+
+	private:
+		double time_min = 1.0;
+		int bins_per_decade = 1;
+		std::vector<double> weights;
+		std::vector<double> sums;
+
+		// Gets the index of the bin that contains the specified time, which can be beyond the last bin
+		int findBin(const double time) const;
+	};
+
+	// Combines the running statistics from all processors onto processor 0 using MPI_Reduce
+	Running_stats MPI_reduceRunningStats(const Running_stats& stats, MPI_Comm comm);
+
+	// Combines the histograms from all processors onto processor 0 using MPI_Reduce
+	// All processors must use histograms with the same bins.
+	Histogram MPI_reduceHistogram(const Histogram& histogram, MPI_Comm comm);
+
+	// Combines the time-binned mean squared displacement data from all processors onto processor 0 using MPI_Reduce
+	// All processors must use accumulators with the same bins.
+	Time_binned_msd MPI_reduceTimeBinnedMsd(const Time_binned_msd& msd, MPI_Comm comm);
+
+	// Combines the reservoir samples from all processors onto processor 0
+	// The samples are gathered to processor 0, which merges them, so the cost scales with the sample capacity.
+	Reservoir_sample MPI_reduceReservoirSample(const Reservoir_sample& sample, MPI_Comm comm);
+
+}
+
+#endif // STATISTICS_H
@@ -0,0 +1,66 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#include "Test_distributor.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace KMC_Lattice_example {
+
+	Test_distributor::Test_distributor(const long int N_tests_total_in, const int chunk_size_in, MPI_Comm comm, mutex& mpi_mutex_in) : mpi_mutex(mpi_mutex_in) {
+		if (!(N_tests_total_in > 0) || !(chunk_size_in > 0)) {
+			throw invalid_argument("Error! The total number of tests and the chunk size must be greater than zero.");
+		}
+		N_tests_total = N_tests_total_in;
+		chunk_size = chunk_size_in;
+		int procid = 0;
+		MPI_Comm_rank(comm, &procid);
+		// Only processor 0 holds the counter, all other processors create a window of size zero
+		MPI_Aint window_size = (procid == 0) ? (MPI_Aint)sizeof(long int) : 0;
+		MPI_Win_allocate(window_size, sizeof(long int), MPI_INFO_NULL, comm, &counter_ptr, &window);
+		if (procid == 0) {
+			MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, window);
+			*counter_ptr = 0;
+			MPI_Win_unlock(0, window);
+		}
+		MPI_Barrier(comm);
+		is_open = true;
+	}
+
+	int Test_distributor::claimChunk() {
+		long int index_first = 0;
+		return claimChunk(index_first);
+	}
+
+	int Test_distributor::claimChunk(long int& index_first) {
+		lock_guard<mutex> lock(mpi_mutex);
+		if (!is_open) {
+			return 0;
+		}
+		// Atomically add one chunk to the counter and get the previous value
+		long int increment = chunk_size;
+		long int N_claimed_prev = 0;
+		MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, window);
+		MPI_Fetch_and_op(&increment, &N_claimed_prev, MPI_LONG, 0, 0, MPI_SUM, window);
+		MPI_Win_unlock(0, window);
+		// The last chunk is truncated so that exactly N_tests_total tests are handed out
+		if (!(N_claimed_prev < N_tests_total)) {
+			return 0;
+		}
+		index_first = N_claimed_prev;
+		return (int)min((long int)chunk_size, N_tests_total - N_claimed_prev);
+	}
+
+	void Test_distributor::close() {
+		lock_guard<mutex> lock(mpi_mutex);
+		if (is_open) {
+			MPI_Win_free(&window);
+			is_open = false;
+		}
+	}
+
+}
@@ -0,0 +1,51 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+#ifndef TEST_DISTRIBUTOR_H
+#define TEST_DISTRIBUTOR_H
+
+#include <mpi.h>
+#include <mutex>
+
+namespace KMC_Lattice_example {
+
+	// This class distributes a global budget of tests across all processors and threads in fixed-size chunks.
+	// The number of tests handed out so far is stored in an MPI window on processor 0 and each claim
+	// atomically increments it using MPI_Fetch_and_op, so faster processors simply claim more chunks and
+	// processor 0 does not need to actively respond to requests.
+	class Test_distributor {
+	public:
+		// Constructs the distributor and creates the shared counter window.  This is a collective operation
+		// that must be called by all processors in the communicator.  All MPI calls of the distributor are made while
+		// holding mpi_mutex, which must also be held by any other thread that makes MPI calls at the same time.
+		Test_distributor(const long int N_tests_total, const int chunk_size, MPI_Comm comm, std::mutex& mpi_mutex);
+
+		// Claims the next chunk of tests and returns the number of tests claimed, which is zero when the
+		// global budget has been used up.  This function can be called from multiple threads, but the MPI
+		// library must have been initialized with at least MPI_THREAD_SERIALIZED support.
+		int claimChunk();
+
+		// Claims the next chunk of tests, sets index_first to the index of the first claimed test, and returns the
+		// number of tests claimed, which is zero when the global budget has been used up.  This allows the distributor
+		// to hand out indexed tasks, such as the configurations of a parameter sweep.
+		int claimChunk(long int& index_first);
+
+		// Frees the shared counter window.  This is a collective operation that must be called by all processors
+		// in the communicator before MPI_Finalize.
+		void close();
+
+	private:
+		long int N_tests_total;
+		int chunk_size;
+		MPI_Win window;
+		long int* counter_ptr = nullptr;
+		bool is_open = false;
+		// Serializes MPI calls from multiple threads on the same processor
+		std::mutex& mpi_mutex;
+	};
+
+}
+
+#endif // TEST_DISTRIBUTOR_H
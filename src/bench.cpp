@@ -0,0 +1,232 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+// This program contains microbenchmarks of the main Exciton_sim functions and an end-to-end benchmark of the
+// exciton diffusion test.  All results are printed to the command line in JSON format so that they can be
+// tracked across versions.  It is built with "make bench".
+
+#include "Exciton_sim.h"
+#include "Parameters.h"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace KMC_Lattice;
+using namespace KMC_Lattice_example;
+
+namespace KMC_Lattice_example {
+
+	// Stores the result of one benchmark
+	struct Benchmark_result {
+		std::string name;
+		std::vector<std::pair<std::string, double>> params;
+		long int iterations;
+		double ns_per_op;
+	};
+
+	// This class is a friend of Exciton_sim so that its private functions can be timed in isolation
+	class Exciton_sim_benchmark {
+	public:
+		// Creates the parameters used by all benchmarks for the specified lattice size and FRET cutoff
+		static Parameters createParameters(const int lattice_size, const int fret_cutoff);
+
+		// Times the construction of the simulation and its lattice
+		static Benchmark_result benchmarkConstruction(const int lattice_size);
+
+		// Times calculateExcitonEvents for all excitons in a lattice with the specified occupancy
+		static Benchmark_result benchmarkCalculateExcitonEvents(const int lattice_size, const int fret_cutoff, const double occupancy);
+
+		// Times calculateExcitonCreationCoords in a lattice with the specified occupancy
+		static Benchmark_result benchmarkCalculateExcitonCreationCoords(const int lattice_size, const double occupancy);
+
+		// Times executeNextEvent in a lattice that starts at the specified occupancy using either the default engine
+		// with the scan of all exciton events or the event heap scheduler, or the global BKL engine
+		static Benchmark_result benchmarkExecuteNextEvent(const int lattice_size, const int fret_cutoff, const double occupancy, const bool Enable_global_bkl, const bool Enable_event_heap);
+
+		// Runs the exciton diffusion test with the default parameters and a fixed seed and measures the event rate
+		static Benchmark_result benchmarkDiffusionTest(const uint64_t seed);
+
+	private:
+		// Fills the lattice with excitons until the specified fraction of sites is occupied
+		static void fillLattice(Exciton_sim& sim, const double occupancy);
+	};
+
+	Parameters Exciton_sim_benchmark::createParameters(const int lattice_size, const int fret_cutoff) {
+		Parameters params;
+		params.Enable_FRM = false;
+		params.Enable_selective_recalc = true;
+		params.Recalc_cutoff = fret_cutoff;
+		params.Enable_full_recalc = false;
+		params.Params_lattice.Enable_periodic_x = true;
+		params.Params_lattice.Enable_periodic_y = true;
+		params.Params_lattice.Enable_periodic_z = true;
+		params.Params_lattice.Length = lattice_size;
+		params.Params_lattice.Width = lattice_size;
+		params.Params_lattice.Height = lattice_size;
+		params.Params_lattice.Unit_size = 1.0;
+		params.Temperature = 300;
+		params.Enable_diffusion_test = true;
+		params.N_tests = 1000;
+		params.Exciton_generation_rate = 1e22;
+		params.Exciton_lifetime = 500e-12;
+		params.R_exciton_hopping = 1e12;
+		params.FRET_cutoff = fret_cutoff;
+		params.Enable_gaussian_dos = true;
+		params.Site_energy_stdev = 0.05;
+		params.Enable_exponential_dos = false;
+		params.Site_energy_urbach = 0.03;
+		// A fixed seed makes the site energies and all events of each benchmark the same in every run
+		params.Random_seed = 1;
+		return params;
+	}
+
+	void Exciton_sim_benchmark::fillLattice(Exciton_sim& sim, const double occupancy) {
+		long int N_target = (long int)(occupancy*sim.lattice.getNumSites());
+		while (sim.N_excitons < N_target) {
+			sim.executeExcitonCreation(&sim.exciton_creation_event);
+		}
+	}
+
+	Benchmark_result Exciton_sim_benchmark::benchmarkConstruction(const int lattice_size) {
+		Parameters params = createParameters(lattice_size, 3);
+		const int N_repeats = 3;
+		auto time_start = chrono::steady_clock::now();
+		for (int i = 0; i < N_repeats; i++) {
+			Exciton_sim sim(params, 0);
+		}
+		auto time_end = chrono::steady_clock::now();
+		double ns = chrono::duration<double, nano>(time_end - time_start).count();
+		return { "construction", { { "lattice_size", lattice_size } }, N_repeats, ns / N_repeats };
+	}
+
+	Benchmark_result Exciton_sim_benchmark::benchmarkCalculateExcitonEvents(const int lattice_size, const int fret_cutoff, const double occupancy) {
+		Exciton_sim sim(createParameters(lattice_size, fret_cutoff), 0);
+		fillLattice(sim, occupancy);
+		// Make sure there is at least one exciton to calculate events for
+		if (sim.N_excitons == 0) {
+			sim.executeExcitonCreation(&sim.exciton_creation_event);
+		}
+		vector<Exciton*> exciton_ptrs;
+		for (auto& item : sim.exciton_slots) {
+			if (item.is_active) {
+				exciton_ptrs.push_back(&item.exciton);
+			}
+		}
+		// Repeat until at least 100000 calculations have been performed
+		long int iterations = 0;
+		auto time_start = chrono::steady_clock::now();
+		while (iterations < 100000) {
+			for (auto item : exciton_ptrs) {
+				sim.calculateExcitonEvents(item);
+			}
+			iterations += (long int)exciton_ptrs.size();
+		}
+		auto time_end = chrono::steady_clock::now();
+		double ns = chrono::duration<double, nano>(time_end - time_start).count();
+		return { "calculateExcitonEvents", { { "lattice_size", lattice_size }, { "fret_cutoff", fret_cutoff }, { "occupancy", occupancy } }, iterations, ns / iterations };
+	}
+
+	Benchmark_result Exciton_sim_benchmark::benchmarkCalculateExcitonCreationCoords(const int lattice_size, const double occupancy) {
+		Exciton_sim sim(createParameters(lattice_size, 3), 0);
+		fillLattice(sim, occupancy);
+		const long int iterations = 1000000;
+		long int checksum = 0;
+		auto time_start = chrono::steady_clock::now();
+		for (long int i = 0; i < iterations; i++) {
+			checksum += sim.calculateExcitonCreationCoords().x;
+		}
+		auto time_end = chrono::steady_clock::now();
+		double ns = chrono::duration<double, nano>(time_end - time_start).count();
+		// Store the checksum in a volatile variable so that the compiler cannot remove the loop
+		volatile long int checksum_sink = checksum;
+		(void)checksum_sink;
+		return { "calculateExcitonCreationCoords", { { "lattice_size", lattice_size }, { "occupancy", occupancy } }, iterations, ns / iterations };
+	}
+
+	Benchmark_result Exciton_sim_benchmark::benchmarkExecuteNextEvent(const int lattice_size, const int fret_cutoff, const double occupancy, const bool Enable_global_bkl, const bool Enable_event_heap) {
+		Parameters params = createParameters(lattice_size, fret_cutoff);
+		params.Enable_global_bkl = Enable_global_bkl;
+		params.Enable_event_heap = Enable_event_heap;
+		Exciton_sim sim(params, 0);
+		fillLattice(sim, occupancy);
+		const long int iterations = 200000;
+		auto time_start = chrono::steady_clock::now();
+		for (long int i = 0; i < iterations; i++) {
+			if (!sim.executeNextEvent()) {
+				break;
+			}
+		}
+		auto time_end = chrono::steady_clock::now();
+		double ns = chrono::duration<double, nano>(time_end - time_start).count();
+		return { "executeNextEvent", { { "lattice_size", lattice_size }, { "fret_cutoff", fret_cutoff }, { "occupancy", occupancy }, { "global_bkl", (double)Enable_global_bkl }, { "event_heap", (double)Enable_event_heap } }, iterations, ns / iterations };
+	}
+
+	Benchmark_result Exciton_sim_benchmark::benchmarkDiffusionTest(const uint64_t seed) {
+		auto time_start = chrono::steady_clock::now();
+		Parameters params = createParameters(50, 3);
+		params.Random_seed = seed;
+		Exciton_sim sim(params, 0);
+		while (!sim.checkFinished()) {
+			if (!sim.executeNextEvent()) {
+				break;
+			}
+		}
+		auto time_end = chrono::steady_clock::now();
+		double ns = chrono::duration<double, nano>(time_end - time_start).count();
+		long int iterations = sim.getN_events_executed();
+		return { "diffusion_test", { { "seed", (double)seed }, { "events_per_second", 1e9*iterations / ns }, { "diffusion_length", sim.calculateDiffusionLength_avg() } }, iterations, ns / iterations };
+	}
+
+}
+
+// Prints one benchmark result as a JSON object
+string toJSON(const Benchmark_result& result) {
+	stringstream ss;
+	ss << "{\"name\": \"" << result.name << "\", \"params\": {";
+	for (int i = 0; i < (int)result.params.size(); i++) {
+		ss << (i > 0 ? ", " : "") << "\"" << result.params[i].first << "\": " << result.params[i].second;
+	}
+	ss << "}, \"iterations\": " << result.iterations << ", \"ns_per_op\": " << result.ns_per_op << "}";
+	return ss.str();
+}
+
+int main() {
+	vector<Benchmark_result> results;
+	for (int lattice_size : { 20, 50, 100 }) {
+		results.push_back(Exciton_sim_benchmark::benchmarkConstruction(lattice_size));
+	}
+	for (int lattice_size : { 20, 50, 100 }) {
+		for (double occupancy : { 0.001, 0.01, 0.1 }) {
+			results.push_back(Exciton_sim_benchmark::benchmarkCalculateExcitonEvents(lattice_size, 3, occupancy));
+		}
+	}
+	for (int fret_cutoff : { 1, 2, 4 }) {
+		results.push_back(Exciton_sim_benchmark::benchmarkCalculateExcitonEvents(50, fret_cutoff, 0.01));
+	}
+	for (int lattice_size : { 20, 50, 100 }) {
+		for (double occupancy : { 0.001, 0.1, 0.5 }) {
+			results.push_back(Exciton_sim_benchmark::benchmarkCalculateExcitonCreationCoords(lattice_size, occupancy));
+		}
+	}
+	// The default engine is run with the scan of all exciton events and with the event heap scheduler
+	for (int engine = 0; engine < 3; engine++) {
+		for (double occupancy : { 0.0, 0.001, 0.01, 0.05 }) {
+			results.push_back(Exciton_sim_benchmark::benchmarkExecuteNextEvent(50, 3, occupancy, engine == 2, engine == 1));
+		}
+	}
+	for (uint64_t seed : { 1, 2, 3 }) {
+		results.push_back(Exciton_sim_benchmark::benchmarkDiffusionTest(seed));
+	}
+	cout << "{\"benchmarks\": [\n";
+	for (int i = 0; i < (int)results.size(); i++) {
+		cout << "  " << toJSON(results[i]) << (i + 1 < (int)results.size() ? ",\n" : "\n");
+	}
+	cout << "]}" << endl;
+	return 0;
+}
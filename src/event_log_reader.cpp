@@ -0,0 +1,60 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+// This program converts a binary event log written by KMC_Lattice_example with the --event_log option into a CSV file
+// with one line per event.  It is built with "make log_reader" and takes the names of the log file and the CSV file as
+// its two input arguments.
+
+#include "Event_log.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace KMC_Lattice_example;
+
+int main(int argc, char *argv[]) {
+	if (argc != 3) {
+		cout << "Error! The event log file and the output CSV file must be specified.  Program will now exit." << endl;
+		return 0;
+	}
+	ifstream logfile(argv[1], ifstream::binary);
+	bool Enable_compression = false;
+	if (!logfile || !Event_log::readHeader(logfile, Enable_compression)) {
+		cout << "Error! " << argv[1] << " is not a valid event log file.  Program will now exit." << endl;
+		return 0;
+	}
+	ofstream csvfile(argv[2]);
+	if (!csvfile) {
+		cout << "Error! The output file " << argv[2] << " could not be created.  Program will now exit." << endl;
+		return 0;
+	}
+	// The event codes are the values of the Exciton::Event_code enum
+	const string event_names[] = { "Creation", "Hop", "Recombination" };
+	csvfile.precision(15);
+	csvfile << "Time (s),Event,Tag,X initial,Y initial,Z initial,X dest,Y dest,Z dest\n";
+	vector<Event_record> records;
+	long int N_records = 0;
+	while (logfile.peek() != EOF) {
+		if (!Event_log::readBlock(logfile, Enable_compression, records)) {
+			cout << "Warning! The last block of " << argv[1] << " is incomplete and was skipped." << endl;
+			break;
+		}
+		for (const auto& record : records) {
+			csvfile << record.time << ",";
+			if (record.event_code >= 0 && record.event_code < 3) {
+				csvfile << event_names[record.event_code];
+			}
+			else {
+				csvfile << record.event_code;
+			}
+			csvfile << "," << record.tag << "," << record.x_initial << "," << record.y_initial << "," << record.z_initial << "," << record.x_dest << "," << record.y_dest << "," << record.z_dest << "\n";
+		}
+		N_records += (long int)records.size();
+	}
+	csvfile.close();
+	cout << N_records << " events were converted from " << argv[1] << " to " << argv[2] << "." << endl;
+	return 0;
+}
@@ -3,22 +3,170 @@
 // For more information, see the LICENSE file that accompanies this software.
 // The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
 
+#include "Energy_landscape.h"
 #include "Exciton_sim.h"
+#include "Parameter_sweep.h"
 #include "Parameters.h"
+#include "Profiler.h"
+#include "Progress_monitor.h"
+#include "Statistics.h"
+#include "Test_distributor.h"
 #include "Utils.h"
 #include <mpi.h>
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace std;
 using namespace KMC_Lattice;
 using namespace KMC_Lattice_example;
 
+// Gets the name of the checkpoint file for the simulation replica with the specified id
+string getCheckpointFilename(const int replica_id) {
+	return "checkpoint" + to_string(replica_id) + ".bin";
+}
+
+// Runs the simulation loop of one simulation replica until the simulation test is finished.
+// When a test distributor is given, the simulation is extended with additional chunks of tests until the 
+// global test budget has been used up.
+// When the checkpoint interval is greater than zero, a checkpoint file is written each time the specified
+// wall-clock time in seconds has passed since the previous checkpoint.
+// When a progress monitor is given, the progress counters of the simulation are posted to it periodically.
+// Returns false if an event execution fails.
+bool runSimulation(Exciton_sim& sim, Test_distributor* distributor_ptr, const double checkpoint_interval, Progress_monitor* monitor_ptr) {
+	cout << sim.getId() << ": Starting simulation..." << endl;
+	auto checkpoint_time_prev = chrono::steady_clock::now();
+	bool End_sim = false;
+	while (!End_sim) {
+		if (!sim.executeNextEvent()) {
+			cout << sim.getId() << ": Event execution failed, simulation will now terminate." << endl;
+			return false;
+		}
+		// Check if simulation has finished
+		End_sim = sim.checkFinished();
+		if (End_sim && distributor_ptr != nullptr) {
+			int N_tests_claimed = distributor_ptr->claimChunk();
+			if (N_tests_claimed > 0) {
+				sim.setN_tests_target(sim.getN_tests_target() + N_tests_claimed);
+				End_sim = false;
+			}
+		}
+		// Post the progress counters to the progress monitor, which combines them from all processors without blocking
+		if (monitor_ptr != nullptr && sim.getN_events_executed() % 1000 == 0) {
+			monitor_ptr->post(sim.getId(), sim.getN_excitons_recombined(), sim.getN_events_executed(), sim.getTime());
+			monitor_ptr->poll();
+		}
+		// Write a checkpoint file when the checkpoint interval has passed
+		// The clock is only checked periodically to keep the overhead low
+		if (checkpoint_interval > 0 && sim.getN_events_executed() % 1000 == 0) {
+			auto time_now = chrono::steady_clock::now();
+			if (chrono::duration<double>(time_now - checkpoint_time_prev).count() >= checkpoint_interval) {
+				if (sim.saveCheckpoint(getCheckpointFilename(sim.getId()))) {
+					cout << sim.getId() << ": Checkpoint saved at simulation time " << sim.getTime() << " seconds." << endl;
+				}
+				checkpoint_time_prev = time_now;
+			}
+		}
+	}
+	if (monitor_ptr != nullptr) {
+		monitor_ptr->post(sim.getId(), sim.getN_excitons_recombined(), sim.getN_events_executed(), sim.getTime());
+	}
+	cout << sim.getId() << ": Simulation finished." << endl;
+	return true;
+}
+
+// Identifies one simulation task of a parameter sweep, which is one replica of one sweep configuration
+struct Sweep_task {
+	int config_index;
+	int replica_id;
+};
+
+// Stores the combined results of the replicas of one sweep configuration
+struct Sweep_result {
+	int N_replicas = 0;
+	long int N_events_executed = 0;
+	long int N_excitons_created = 0;
+	long int N_excitons_recombined = 0;
+	Running_stats diffusion_stats;
+};
+
+// Creates the list of all sweep tasks in the order in which they are handed out.
+// Configurations with the same lattice and site energies are grouped together, and within each group the
+// configurations of each replica are listed consecutively, because a simulation can only be reconfigured for
+// another configuration with the same replica id.
+vector<Sweep_task> createSweepTasks(const Parameter_sweep& sweep, const int N_replicas) {
+	vector<vector<int>> groups;
+	for (int i = 0; i < sweep.getN_configs(); i++) {
+		auto group_it = find_if(groups.begin(), groups.end(), [&](const vector<int>& group) {
+			return Exciton_sim::checkLatticeReusable(sweep.getParams(group[0]), sweep.getParams(i));
+		});
+		if (group_it == groups.end()) {
+			groups.push_back(vector<int>(1, i));
+		}
+		else {
+			group_it->push_back(i);
+		}
+	}
+	vector<Sweep_task> tasks;
+	for (const auto& group : groups) {
+		for (int replica_id = 0; replica_id < N_replicas; replica_id++) {
+			for (int config_index : group) {
+				tasks.push_back({ config_index, replica_id });
+			}
+		}
+	}
+	return tasks;
+}
+
+// Runs the sweep tasks claimed from the distributor until all tasks have been handed out and adds the results of
+// each task to the results of its configuration.
+// The simulation of the previous task is reconfigured for the next task whenever it has the same replica id and the
+// same site energies, so that the lattice and the site energy landscape do not need to be created again.
+// Returns false if a simulation fails.
+bool runSweepTasks(const Parameter_sweep& sweep, const vector<Sweep_task>& tasks, Test_distributor& distributor, const Energy_landscape* landscape_ptr, vector<Sweep_result>& results) {
+	unique_ptr<Exciton_sim> sim;
+	long int task_first = 0;
+	int N_claimed = 0;
+	while ((N_claimed = distributor.claimChunk(task_first)) > 0) {
+		for (long int i = task_first; i < task_first + N_claimed; i++) {
+			const Sweep_task& task = tasks[i];
+			const Parameters& params_task = sweep.getParams(task.config_index);
+			if (sim && sim->getId() == task.replica_id && sim->reconfigure(params_task)) {
+				cout << task.replica_id << ": Reusing the lattice for configuration " << task.config_index << "." << endl;
+			}
+			else {
+				// Release the previous simulation before the new lattice is allocated
+				sim.reset();
+				cout << task.replica_id << ": Initializing simulation for configuration " << task.config_index << "..." << endl;
+				sim.reset(new Exciton_sim(params_task, task.replica_id, landscape_ptr));
+			}
+			if (!runSimulation(*sim, nullptr, 0, nullptr)) {
+				return false;
+			}
+			Sweep_result& result = results[task.config_index];
+			result.N_replicas++;
+			result.N_events_executed += sim->getN_events_executed();
+			result.N_excitons_created += sim->getN_excitons_created();
+			result.N_excitons_recombined += sim->getN_excitons_recombined();
+			if (params_task.Enable_diffusion_test) {
+				result.diffusion_stats.merge(sim->getDiffusionStats());
+			}
+		}
+	}
+	return true;
+}
+
 int main(int argc, char *argv[]) {
 	// Initialize mpi options
+	// Simulation threads only make MPI calls when claiming test chunks, and those calls are serialized
 	cout << "Initializing MPI options... ";
-	MPI_Init(&argc, &argv);
+	int thread_support = 0;
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &thread_support);
 	int nproc = 1;
 	int procid = 0;
 	MPI_Comm_size(MPI_COMM_WORLD, &nproc);
@@ -26,8 +174,181 @@ int main(int argc, char *argv[]) {
 	cout << "MPI initialization complete!" << endl;
 	// Start timer
 	auto time_start = time(NULL);
+	auto phase_time_start = chrono::steady_clock::now();
+	// Parse optional command line arguments
+	// --threads N sets the number of independent simulation replicas that are run on separate threads by each processor
+	// --chunk_size M enables dynamic work distribution, where N_tests is the total number of tests for all processors
+	// and each replica repeatedly claims chunks of M tests until all tests have been handed out
+	// --sample_size K stores a random sample of K exciton displacement distances in addition to the streaming statistics
+	int N_threads = 1;
+	int chunk_size = 0;
+	// --checkpoint_interval S writes a checkpoint file for each replica every S seconds of wall-clock time
+	// --restart resumes each replica from its checkpoint file
+	// --independent_walkers simulates each exciton as a standalone walker in the non-interacting limit
+	// --compact_sites stores the site energies in float arrays to reduce the memory needed for very large lattices
+	// --sparse_sites stores only the occupied sites and calculates the site energies when they are needed
+	// --landscape FILE reads the site energies from a binary landscape file instead of creating them
+	// --shared_landscape loads the landscape file once per node into shared memory instead of memory-mapping it on each processor
+	// --dos_threads T sets the number of threads used by each replica to create correlated site energies
+	// --global_bkl selects the next event with the global BKL engine, which stores the total rate of each exciton in a Fenwick tree
+	// --event_log writes a binary log of all executed events of each replica to an event_log#.bin file
+	// --compress_log compresses the event log files
+	// --progress_interval S prints the combined progress of all processors every S seconds of wall-clock time, or never if S is 0
+	// --event_heap schedules the next event of each exciton in an indexed binary heap instead of checking the next events of all excitons
+	// --seed N sets the seed of the random number streams of all replicas, so that the results of each replica only depend on N and its replica id
+	// --sweep FILE runs every configuration listed in the sweep file in one job and writes the results to one table
+	// --sweep_replicas R sets the number of replicas that are run for each sweep configuration
+	int sample_size = 0;
+	double checkpoint_interval = 0;
+	bool Enable_restart = false;
+	bool Enable_independent_walkers = false;
+	bool Enable_compact_sites = false;
+	bool Enable_sparse_sites = false;
+	string landscape_filename;
+	bool Enable_shared_landscape = false;
+	int N_dos_threads = 1;
+	bool Enable_global_bkl = false;
+	bool Enable_event_heap = false;
+	bool Enable_event_log = false;
+	bool Enable_log_compression = false;
+	string sweep_filename;
+	int N_sweep_replicas = 1;
+	double progress_interval = 60;
+	uint64_t random_seed = 0;
+	for (int i = 2; i < argc; i++) {
+		string arg = argv[i];
+		if (arg.compare("--threads") == 0 && i + 1 < argc) {
+			N_threads = atoi(argv[++i]);
+		}
+		else if (arg.compare("--sample_size") == 0 && i + 1 < argc) {
+			sample_size = atoi(argv[++i]);
+			if (sample_size < 0) {
+				cout << "Error! The diffusion sample size cannot be negative.  Program will now exit." << endl;
+				return 0;
+			}
+		}
+		else if (arg.compare("--checkpoint_interval") == 0 && i + 1 < argc) {
+			checkpoint_interval = atof(argv[++i]);
+			if (!(checkpoint_interval > 0)) {
+				cout << "Error! The checkpoint interval must be greater than zero.  Program will now exit." << endl;
+				return 0;
+			}
+		}
+		else if (arg.compare("--restart") == 0) {
+			Enable_restart = true;
+		}
+		else if (arg.compare("--independent_walkers") == 0) {
+			Enable_independent_walkers = true;
+		}
+		else if (arg.compare("--compact_sites") == 0) {
+			Enable_compact_sites = true;
+		}
+		else if (arg.compare("--sparse_sites") == 0) {
+			Enable_sparse_sites = true;
+		}
+		else if (arg.compare("--landscape") == 0 && i + 1 < argc) {
+			landscape_filename = argv[++i];
+		}
+		else if (arg.compare("--shared_landscape") == 0) {
+			Enable_shared_landscape = true;
+		}
+		else if (arg.compare("--dos_threads") == 0 && i + 1 < argc) {
+			N_dos_threads = atoi(argv[++i]);
+			if (N_dos_threads < 1) {
+				cout << "Error! The number of site energy creation threads must be greater than zero.  Program will now exit." << endl;
+				return 0;
+			}
+		}
+		else if (arg.compare("--global_bkl") == 0) {
+			Enable_global_bkl = true;
+		}
+		else if (arg.compare("--event_heap") == 0) {
+			Enable_event_heap = true;
+		}
+		else if (arg.compare("--progress_interval") == 0 && i + 1 < argc) {
+			progress_interval = atof(argv[++i]);
+			if (progress_interval < 0) {
+				cout << "Error! The progress report interval cannot be negative.  Program will now exit." << endl;
+				return 0;
+			}
+		}
+		else if (arg.compare("--event_log") == 0) {
+			Enable_event_log = true;
+		}
+		else if (arg.compare("--compress_log") == 0) {
+			Enable_log_compression = true;
+		}
+		else if (arg.compare("--seed") == 0 && i + 1 < argc) {
+			random_seed = strtoull(argv[++i], nullptr, 10);
+			if (random_seed == 0) {
+				cout << "Error! The random seed must be greater than zero.  Program will now exit." << endl;
+				return 0;
+			}
+		}
+		else if (arg.compare("--sweep") == 0 && i + 1 < argc) {
+			sweep_filename = argv[++i];
+		}
+		else if (arg.compare("--sweep_replicas") == 0 && i + 1 < argc) {
+			N_sweep_replicas = atoi(argv[++i]);
+			if (N_sweep_replicas < 1) {
+				cout << "Error! The number of sweep replicas must be greater than zero.  Program will now exit." << endl;
+				return 0;
+			}
+		}
+		else if (arg.compare("--chunk_size") == 0 && i + 1 < argc) {
+			chunk_size = atoi(argv[++i]);
+			if (!(chunk_size > 0)) {
+				cout << "Error! The test chunk size must be greater than zero.  Program will now exit." << endl;
+				return 0;
+			}
+		}
+		else {
+			cout << "Error! Unrecognized command line argument " << arg << ".  Program will now exit." << endl;
+			return 0;
+		}
+	}
+	if (Enable_restart && chunk_size > 0) {
+		cout << "Error! Simulations with dynamic work distribution cannot be restarted from checkpoints.  Program will now exit." << endl;
+		return 0;
+	}
+	if (Enable_independent_walkers && (chunk_size > 0 || checkpoint_interval > 0 || Enable_restart)) {
+		cout << "Error! Independent walker simulations cannot be combined with dynamic work distribution or checkpoints.  Program will now exit." << endl;
+		return 0;
+	}
+	if (Enable_compact_sites && Enable_sparse_sites) {
+		cout << "Error! The compact and sparse site storage options cannot both be enabled.  Program will now exit." << endl;
+		return 0;
+	}
+	if (!sweep_filename.empty() && (chunk_size > 0 || checkpoint_interval > 0 || Enable_restart || Enable_independent_walkers || sample_size > 0)) {
+		cout << "Error! Parameter sweeps cannot be combined with dynamic work distribution, checkpoints, independent walkers, or diffusion samples.  Program will now exit." << endl;
+		return 0;
+	}
+	if (Enable_event_log && (Enable_restart || Enable_independent_walkers || !sweep_filename.empty())) {
+		cout << "Error! Event logs cannot be combined with restarts, independent walkers, or parameter sweeps.  Program will now exit." << endl;
+		return 0;
+	}
+	if (Enable_log_compression && !Enable_event_log) {
+		cout << "Error! The log compression option requires the event log option.  Program will now exit." << endl;
+		return 0;
+	}
+	if (Enable_global_bkl && Enable_event_heap) {
+		cout << "Error! The global BKL engine and the event heap scheduler cannot both be enabled.  Program will now exit." << endl;
+		return 0;
+	}
+	if (Enable_shared_landscape && landscape_filename.empty()) {
+		cout << "Error! The shared landscape option requires a landscape file.  Program will now exit." << endl;
+		return 0;
+	}
+	if (N_threads < 1) {
+		cout << "Error! The number of threads must be greater than zero.  Program will now exit." << endl;
+		return 0;
+	}
 	// Import parameters and options from file and command line arguments
 	cout << "Loading input parameters from file... " << endl;
+	if (argc < 2) {
+		cout << "Error! No parameter file was specified.  Program will now exit." << endl;
+		return 0;
+	}
 	ifstream parameterfile(argv[1], ifstream::in);
 	if (!parameterfile) {
 		cout << "Error loading parameter file.  Program will now exit." << endl;
@@ -36,62 +357,412 @@ int main(int argc, char *argv[]) {
 	Parameters params;
 	bool success = params.importParameters(parameterfile);
 	parameterfile.close();
-	if (!success) {
+	if (!success || !params.checkParameters()) {
 		cout << "Error importing parameters from parameter file.  Program will now exit." << endl;
 		return 0;
 	}
+	params.Enable_compact_sites = Enable_compact_sites;
+	params.Enable_sparse_sites = Enable_sparse_sites;
+	params.N_dos_threads = N_dos_threads;
+	params.Enable_global_bkl = Enable_global_bkl;
+	params.Enable_event_heap = Enable_event_heap;
+	params.Random_seed = random_seed;
+	if (Enable_global_bkl && params.Enable_FRM) {
+		cout << "Error! The global BKL engine cannot be combined with the first reaction method.  Program will now exit." << endl;
+		return 0;
+	}
+	if (params.Enable_correlated_disorder && Enable_sparse_sites && landscape_filename.empty()) {
+		cout << "Error! The correlated disorder model cannot be combined with the sparse site storage option.  Program will now exit." << endl;
+		return 0;
+	}
+	// The site energies are read from the landscape file, so the correlated disorder model would be silently ignored
+	if (params.Enable_correlated_disorder && !landscape_filename.empty()) {
+		cout << "Error! The correlated disorder model cannot be combined with an energy landscape file.  Program will now exit." << endl;
+		return 0;
+	}
 	cout << "Parameter loading complete!" << endl;
-	// Initialize Simulation
-	cout << procid << ": Initializing simulation " << procid << "..." << endl;
-	Exciton_sim sim(params, procid);
-	cout << procid << ": Simulation initialization complete!" << endl;
-	// Begin Simulation loop
-	cout << procid << ": Starting simulation..." << endl;
-	bool End_sim = false;
-	while (!End_sim) {
-		success = sim.executeNextEvent();
-		if (!success) {
-			cout << procid << ": Event execution failed, simulation will now terminate." << endl;
-			break;
+	// Import the sweep configurations, which override individual parameters from the parameter file
+	Parameter_sweep sweep;
+	if (!sweep_filename.empty()) {
+		ifstream sweepfile(sweep_filename, ifstream::in);
+		if (!sweepfile) {
+			cout << "Error loading sweep file.  Program will now exit." << endl;
+			return 0;
 		}
-		// Check if simulation has finished
-		End_sim = sim.checkFinished();
-		// Output status
-		if (sim.getN_events_executed() % 100000 == 0) {
-			sim.outputStatus();
+		if (!sweep.importSweep(sweepfile, params)) {
+			cout << "Error importing configurations from sweep file.  Program will now exit." << endl;
+			return 0;
+		}
+		cout << "Loaded " << sweep.getN_configs() << " sweep configurations." << endl;
+	}
+	// Open the energy landscape file, which is used by all simulations on this processor
+	Energy_landscape landscape;
+	MPI_Comm node_comm = MPI_COMM_NULL;
+	if (!landscape_filename.empty()) {
+		cout << procid << ": Opening energy landscape file " << landscape_filename << "..." << endl;
+		bool landscape_success;
+		if (Enable_shared_landscape) {
+			MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, procid, MPI_INFO_NULL, &node_comm);
+			landscape_success = landscape.openShared(landscape_filename, node_comm);
+		}
+		else {
+			landscape_success = landscape.openFile(landscape_filename);
+		}
+		if (!landscape_success) {
+			cout << procid << ": Error opening energy landscape file.  Program will now exit." << endl;
+			return 0;
 		}
+		if (landscape.getLength() != params.Params_lattice.Length || landscape.getWidth() != params.Params_lattice.Width || landscape.getHeight() != params.Params_lattice.Height || landscape.getUnitSize() != params.Params_lattice.Unit_size) {
+			cout << procid << ": Error! The energy landscape does not match the lattice parameters.  Program will now exit." << endl;
+			return 0;
+		}
+	}
+	const Energy_landscape* landscape_ptr = landscape_filename.empty() ? nullptr : &landscape;
+	// Report the predicted memory usage once before any lattice data is allocated
+	// Each thread of a processor holds the lattice of one replica at a time.
+	if (procid == 0) {
+		double memory_replica = Exciton_sim::predictMemoryUsage(params, landscape_ptr != nullptr);
+		cout << "Predicted peak lattice memory usage is " << memory_replica / 1e6 << " MB per replica and " << N_threads * memory_replica / 1e6 << " MB per processor." << endl;
+	}
+	// Serializes the MPI calls made by the simulation threads
+	mutex mpi_mutex;
+	// Create the shared test counter for dynamic work distribution
+	unique_ptr<Test_distributor> distributor;
+	if (chunk_size > 0) {
+		if (N_threads > 1 && thread_support < MPI_THREAD_SERIALIZED) {
+			cout << "Error! The MPI library does not support dynamic work distribution with multiple threads.  Program will now exit." << endl;
+			return 0;
+		}
+		distributor.reset(new Test_distributor(params.N_tests, chunk_size, MPI_COMM_WORLD, mpi_mutex));
+	}
+	double init_time = chrono::duration<double>(chrono::steady_clock::now() - phase_time_start).count();
+	phase_time_start = chrono::steady_clock::now();
+	// In a parameter sweep, each thread of each processor claims chunks of (configuration, replica) tasks from a shared
+	// task counter, and the results of all tasks are combined into one table with one row per configuration
+	if (!sweep_filename.empty()) {
+		vector<Sweep_task> tasks = createSweepTasks(sweep, N_sweep_replicas);
+		// The worker threads claim their tasks with MPI calls, so only one worker thread is used when the MPI library does not
+		// support serialized calls from several threads
+		int N_sweep_threads = N_threads;
+		if (N_threads > 1 && thread_support < MPI_THREAD_SERIALIZED) {
+			cout << procid << ": Warning! The MPI library does not support parameter sweeps with multiple threads, so only one thread will be used." << endl;
+			N_sweep_threads = 1;
+		}
+		// Each worker claims several consecutive tasks at a time so that it can reuse its lattice between them, while the
+		// chunks are small enough to balance the load between the workers
+		int N_workers = nproc * N_sweep_threads;
+		int task_chunk_size = max(1, (int)tasks.size() / (4 * N_workers));
+		Test_distributor task_distributor((long int)tasks.size(), task_chunk_size, MPI_COMM_WORLD, mpi_mutex);
+		vector<vector<Sweep_result>> results_threads(N_sweep_threads, vector<Sweep_result>(sweep.getN_configs()));
+		vector<char> worker_success(N_sweep_threads, 0);
+		auto runWorker = [&](const int thread_num) {
+			worker_success[thread_num] = runSweepTasks(sweep, tasks, task_distributor, landscape_ptr, results_threads[thread_num]);
+		};
+		if (N_sweep_threads == 1) {
+			runWorker(0);
+		}
+		else {
+			vector<thread> threads;
+			for (int i = 0; i < N_sweep_threads; i++) {
+				threads.emplace_back(runWorker, i);
+			}
+			for (auto& item : threads) {
+				item.join();
+			}
+		}
+		task_distributor.close();
+		// A failed worker stops claiming tasks, so the results of its configurations would be incomplete, and no sweep table is
+		// written if any simulation of any processor failed
+		int N_workers_failed_local = (int)count(worker_success.begin(), worker_success.end(), 0);
+		if (N_workers_failed_local > 0) {
+			cout << procid << ": Error! A sweep simulation failed." << endl;
+		}
+		int N_workers_failed = 0;
+		MPI_Allreduce(&N_workers_failed_local, &N_workers_failed, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+		if (N_workers_failed > 0) {
+			if (procid == 0) {
+				cout << "Error! The parameter sweep did not finish, so no sweep results will be written.  Program will now exit." << endl;
+			}
+			landscape.close();
+			if (node_comm != MPI_COMM_NULL) {
+				MPI_Comm_free(&node_comm);
+			}
+			MPI_Finalize();
+			return 1;
+		}
+		// Combine the results of all threads and then of all processors
+		vector<long int> counts_local(4 * sweep.getN_configs(), 0);
+		vector<Running_stats> diffusion_stats_local(sweep.getN_configs());
+		for (const auto& results : results_threads) {
+			for (int i = 0; i < sweep.getN_configs(); i++) {
+				counts_local[4 * i] += results[i].N_replicas;
+				counts_local[4 * i + 1] += results[i].N_events_executed;
+				counts_local[4 * i + 2] += results[i].N_excitons_created;
+				counts_local[4 * i + 3] += results[i].N_excitons_recombined;
+				diffusion_stats_local[i].merge(results[i].diffusion_stats);
+			}
+		}
+		vector<long int> counts(counts_local.size(), 0);
+		MPI_Reduce(counts_local.data(), counts.data(), (int)counts_local.size(), MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+		vector<Running_stats> diffusion_stats(sweep.getN_configs());
+		for (int i = 0; i < sweep.getN_configs(); i++) {
+			diffusion_stats[i] = MPI_reduceRunningStats(diffusion_stats_local[i], MPI_COMM_WORLD);
+		}
+		if (procid == 0) {
+			ofstream sweepresultsfile("sweep_results.csv");
+			sweepresultsfile << "Configuration";
+			for (const auto& name : sweep.getParameterNames()) {
+				sweepresultsfile << "," << name;
+			}
+			sweepresultsfile << ",Replicas,Events executed,Excitons created,Excitons tested,Diffusion length avg (nm),Diffusion length stdev (nm)\n";
+			for (int i = 0; i < sweep.getN_configs(); i++) {
+				sweepresultsfile << i;
+				for (const auto& name : sweep.getParameterNames()) {
+					sweepresultsfile << "," << sweep.getParams(i).getParameter(name);
+				}
+				sweepresultsfile << "," << counts[4 * i] << "," << counts[4 * i + 1] << "," << counts[4 * i + 2] << "," << counts[4 * i + 3];
+				if (sweep.getParams(i).Enable_diffusion_test) {
+					sweepresultsfile << "," << diffusion_stats[i].getMean() << "," << diffusion_stats[i].getStdev();
+				}
+				else {
+					sweepresultsfile << ",,";
+				}
+				sweepresultsfile << "\n";
+			}
+			sweepresultsfile.close();
+			cout << "Parameter sweep finished in " << difftime(time(NULL), time_start) / 60.0 << " minutes." << endl;
+		}
+		landscape.close();
+		if (node_comm != MPI_COMM_NULL) {
+			MPI_Comm_free(&node_comm);
+		}
+		MPI_Barrier(MPI_COMM_WORLD);
+		MPI_Finalize();
+		return 0;
+	}
+	// Create the progress monitor, which needs serialized MPI support when several threads run simulations
+	// The total number of tests is the global test budget with dynamic work distribution, or the tests of all replicas otherwise.
+	unique_ptr<Progress_monitor> monitor;
+	if (progress_interval > 0 && !Enable_independent_walkers) {
+		if (N_threads > 1 && thread_support < MPI_THREAD_SERIALIZED) {
+			cout << procid << ": Warning! The MPI library does not support progress reporting with multiple threads, so no progress will be reported." << endl;
+		}
+		else {
+			long int N_tests_total = distributor ? (long int)params.N_tests : (long int)params.N_tests*nproc*N_threads;
+			monitor.reset(new Progress_monitor(N_tests_total, progress_interval, MPI_COMM_WORLD, mpi_mutex));
+		}
+	}
+	// Run one simulation replica on each thread
+	// Each replica has a unique id that is used to seed its own random number generator
+	vector<unique_ptr<Exciton_sim>> sims(N_threads);
+	vector<char> replica_success(N_threads, 0);
+	auto runReplica = [&](const int thread_num) {
+		int replica_id = procid * N_threads + thread_num;
+		// With dynamic work distribution, each replica starts with one chunk of tests and is only created if a chunk is available
+		Parameters params_replica = params;
+		if (distributor) {
+			params_replica.N_tests = distributor->claimChunk();
+			if (params_replica.N_tests == 0) {
+				cout << replica_id << ": No tests are left for simulation " << replica_id << "." << endl;
+				replica_success[thread_num] = true;
+				return;
+			}
+		}
+		cout << replica_id << ": Initializing simulation " << replica_id << "..." << endl;
+		sims[thread_num].reset(new Exciton_sim(params_replica, replica_id, landscape_ptr));
+		sims[thread_num]->enableDiffusionSample(sample_size);
+		if (Enable_event_log && !sims[thread_num]->enableEventLog("event_log" + to_string(replica_id) + ".bin", Enable_log_compression)) {
+			return;
+		}
+		// Resume the simulation from its checkpoint file if one exists
+		if (Enable_restart) {
+			string filename = getCheckpointFilename(replica_id);
+			if (!ifstream(filename)) {
+				cout << replica_id << ": No checkpoint file was found, so simulation " << replica_id << " will start from the beginning." << endl;
+			}
+			else if (sims[thread_num]->loadCheckpoint(filename)) {
+				cout << replica_id << ": Simulation resumed from " << filename << " at simulation time " << sims[thread_num]->getTime() << " seconds." << endl;
+			}
+			else {
+				cout << replica_id << ": Error loading checkpoint file, simulation will now terminate." << endl;
+				return;
+			}
+		}
+		cout << replica_id << ": Simulation initialization complete!" << endl;
+		replica_success[thread_num] = runSimulation(*sims[thread_num], distributor.get(), checkpoint_interval, monitor.get());
+		if (Enable_event_log && !sims[thread_num]->closeEventLog()) {
+			replica_success[thread_num] = false;
+		}
+	};
+	// In the independent walker mode, each processor creates one simulation whose site energy landscape is shared by
+	// all threads, and the N_tests walkers are split between the threads
+	if (Enable_independent_walkers) {
+		cout << procid << ": Initializing independent walker simulation " << procid << "..." << endl;
+		sims[0].reset(new Exciton_sim(params, procid, landscape_ptr));
+		sims[0]->enableDiffusionSample(sample_size);
+		cout << procid << ": Simulating " << params.N_tests << " independent exciton walkers on " << N_threads << " threads..." << endl;
+		sims[0]->runIndependentWalkers(params.N_tests, N_threads);
+		cout << procid << ": Simulation finished." << endl;
+	}
+	else if (N_threads == 1) {
+		runReplica(0);
+	}
+	else {
+		vector<thread> threads;
+		for (int i = 0; i < N_threads; i++) {
+			threads.emplace_back(runReplica, i);
+		}
+		for (auto& item : threads) {
+			item.join();
+		}
+	}
+	if (monitor) {
+		monitor->close();
+	}
+	if (distributor) {
+		distributor->close();
+	}
+	// Check that all replicas of all processors finished successfully before any results are combined, so that the partial
+	// results of failed replicas are never written to the output files
+	// The independent walker simulation does not run replicas and cannot fail
+	int N_replicas_failed_local = 0;
+	if (!Enable_independent_walkers) {
+		for (int i = 0; i < N_threads; i++) {
+			if (!replica_success[i]) {
+				cout << procid * N_threads + i << ": Error! Simulation " << procid * N_threads + i << " failed." << endl;
+				N_replicas_failed_local++;
+			}
+		}
+	}
+	int N_replicas_failed = 0;
+	MPI_Allreduce(&N_replicas_failed_local, &N_replicas_failed, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+	if (N_replicas_failed > 0) {
+		if (procid == 0) {
+			cout << "Error! " << N_replicas_failed << " simulations failed, so no results will be written.  Program will now exit." << endl;
+		}
+		landscape.close();
+		if (node_comm != MPI_COMM_NULL) {
+			MPI_Comm_free(&node_comm);
+		}
+		MPI_Finalize();
+		return 1;
 	}
-	cout << procid << ": Simulation finished." << endl;
 	auto time_end = time(NULL);
 	auto elapsedtime = difftime(time_end, time_start);
+	double run_time = chrono::duration<double>(chrono::steady_clock::now() - phase_time_start).count();
+	phase_time_start = chrono::steady_clock::now();
+	// Combine the results of all replicas run by this processor
+	long int N_events_executed = 0;
+	int N_excitons_created = 0;
+	int N_excitons_recombined = 0;
+	Running_stats diffusion_stats_local;
+	Histogram diffusion_histogram_local = Exciton_sim::createDiffusionHistogram(params);
+	Reservoir_sample diffusion_sample_local(sample_size, (unsigned long int)procid);
+	Time_binned_msd diffusion_msd_local = Exciton_sim::createDiffusionMsd(params);
+	Profiler profiler_local;
+	// Replicas that did not receive any tests are skipped
+	sims.erase(remove(sims.begin(), sims.end(), nullptr), sims.end());
+	for (auto& sim : sims) {
+		N_events_executed += sim->getN_events_executed();
+		N_excitons_created += sim->getN_excitons_created();
+		N_excitons_recombined += sim->getN_excitons_recombined();
+		profiler_local.merge(sim->getProfiler());
+		if (params.Enable_diffusion_test) {
+			diffusion_stats_local.merge(sim->getDiffusionStats());
+			diffusion_histogram_local.merge(sim->getDiffusionHistogram());
+			diffusion_sample_local.merge(sim->getDiffusionSample());
+			diffusion_msd_local.merge(sim->getDiffusionMsd());
+		}
+	}
+	profiler_local.setPhaseTime(Profile_phase::Init, init_time);
+	profiler_local.setPhaseTime(Profile_phase::Run, run_time);
+	profiler_local.setPhaseTime(Profile_phase::Gather, chrono::duration<double>(chrono::steady_clock::now() - phase_time_start).count());
 	// Output simulation results for each processor
 	ofstream resultsfile("results" + to_string(procid) + ".txt");
 	resultsfile << "KMC_Lattice_example Results:\n";
 	resultsfile << "Calculation time elapsed is " << (double)elapsedtime / 60.0 << " minutes.\n";
-	resultsfile << sim.getTime() << " seconds have been simulated.\n";
-	resultsfile << sim.getN_events_executed() << " events have been executed.\n";
-	resultsfile << sim.getN_excitons_created() << " excitons have been created.\n";
+	for (auto& sim : sims) {
+		if (N_threads > 1) {
+			resultsfile << "Replica " << sim->getId() << ": ";
+		}
+		resultsfile << sim->getTime() << " seconds have been simulated.\n";
+	}
+	resultsfile << N_events_executed << " events have been executed.\n";
+	resultsfile << N_excitons_created << " excitons have been created.\n";
 	if (params.Enable_diffusion_test) {
 		resultsfile << "Exciton diffusion test results:\n";
-		resultsfile << "Exciton diffusion length is " << sim.calculateDiffusionLength_avg() << "  " << sim.calculateDiffusionLength_stdev() << " nm\n";
+		resultsfile << "Exciton diffusion length is " << diffusion_stats_local.getMean() << "  " << diffusion_stats_local.getStdev() << " nm\n";
+	}
+	if (Profiler::Enabled) {
+		profiler_local.writeReport(resultsfile);
 	}
 	resultsfile << endl;
 	resultsfile.close();
 	// Output overall analysis results from all processors
-	vector<double> diffusion_data;
+	// The streaming statistics from all processors are combined using MPI reductions
+	Running_stats diffusion_stats;
+	Histogram diffusion_histogram;
+	Reservoir_sample diffusion_sample;
+	Time_binned_msd diffusion_msd;
 	if (params.Enable_diffusion_test) {
-		diffusion_data = MPI_gatherVectors(sim.getDiffusionData());
+		diffusion_stats = MPI_reduceRunningStats(diffusion_stats_local, MPI_COMM_WORLD);
+		diffusion_histogram = MPI_reduceHistogram(diffusion_histogram_local, MPI_COMM_WORLD);
+		diffusion_msd = MPI_reduceTimeBinnedMsd(diffusion_msd_local, MPI_COMM_WORLD);
+		if (sample_size > 0) {
+			diffusion_sample = MPI_reduceReservoirSample(diffusion_sample_local, MPI_COMM_WORLD);
+		}
+	}
+	int N_excitons_recombined_total = 0;
+	MPI_Reduce(&N_excitons_recombined, &N_excitons_recombined_total, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+	Profiler profiler;
+	if (Profiler::Enabled) {
+		profiler = MPI_reduceProfiler(profiler_local, MPI_COMM_WORLD);
 	}
 	if (procid == 0) {
 		ofstream analysisfile("analysis_summary.txt");
 		analysisfile << "KMC_Lattice_example Results Summary:" << endl;
-		analysisfile << nproc * sim.getN_excitons_recombined() << " total excitons tested." << endl;
+		analysisfile << N_excitons_recombined_total << " total excitons tested." << endl;
 		if (params.Enable_diffusion_test) {
 			analysisfile << "Overall exciton diffusion test results:\n";
-			analysisfile << "Exciton diffusion length is " << vector_avg(diffusion_data) << "  " << vector_stdev(diffusion_data) << " nm\n";
+			analysisfile << "Exciton diffusion length is " << diffusion_stats.getMean() << "  " << diffusion_stats.getStdev() << " nm\n";
+		}
+		if (Profiler::Enabled) {
+			profiler.writeReport(analysisfile);
 		}
 		analysisfile << endl;
 		analysisfile.close();
+		if (params.Enable_diffusion_test) {
+			// Output the histogram of all exciton displacement distances
+			ofstream histogramfile("diffusion_histogram.txt");
+			histogramfile << "Distance (nm),Count\n";
+			for (int i = 0; i < (int)diffusion_histogram.getCounts().size(); i++) {
+				histogramfile << (i + 0.5)*diffusion_histogram.getBinSize() << "," << diffusion_histogram.getCounts()[i] << "\n";
+			}
+			histogramfile << ">" << diffusion_histogram.getCounts().size()*diffusion_histogram.getBinSize() << "," << diffusion_histogram.getOverflowCount() << "\n";
+			histogramfile.close();
+			// Output the mean squared displacement of the excitons in each time bin that was reached by any exciton
+			// The exciton time is the total time that excitons spent in the bin, which indicates the statistical weight of the bin.
+			ofstream msdfile("diffusion_msd.txt");
+			msdfile << "Time start (s),Time end (s),MSD (nm^2),Exciton time (s)\n";
+			for (int i = 0; i < diffusion_msd.getN_bins(); i++) {
+				if (diffusion_msd.getWeights()[i] > 0) {
+					msdfile << diffusion_msd.getBinStart(i) << "," << diffusion_msd.getBinEnd(i) << "," << diffusion_msd.getMsd(i) << "," << diffusion_msd.getWeights()[i] << "\n";
+				}
+			}
+			msdfile.close();
+		}
+		if (params.Enable_diffusion_test && sample_size > 0) {
+			// Output the random sample of exciton displacement distances
+			ofstream samplefile("diffusion_sample.txt");
+			for (auto item : diffusion_sample.getSample()) {
+				samplefile << item << "\n";
+			}
+			samplefile.close();
+		}
+	}
+	landscape.close();
+	if (node_comm != MPI_COMM_NULL) {
+		MPI_Comm_free(&node_comm);
 	}
 	MPI_Barrier(MPI_COMM_WORLD);
 	MPI_Finalize();
@@ -0,0 +1,296 @@
+// Copyright (c) 2017-2019 Michael C. Heiber
+// This source file is part of the KMC_Lattice_example project, which is subject to the MIT License.
+// For more information, see the LICENSE file that accompanies this software.
+// The KMC_Lattice_example project can be found on Github at https://github.com/MikeHeiber/KMC_Lattice_example
+
+// This program contains regression tests of Exciton_sim for conditions that are not covered by the default parameters.
+// Each failed check is printed to the command line, and the program returns a nonzero exit code if any check fails.
+// It is built and run with "make test".
+
+#include "Exciton_sim.h"
+#include "Parameters.h"
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace KMC_Lattice;
+using namespace KMC_Lattice_example;
+
+namespace KMC_Lattice_example {
+
+	// This class is a friend of Exciton_sim so that the internal state of a simulation can be checked
+	class Exciton_sim_test {
+	public:
+		// Creates the parameters used by all tests with the specified temperature and site energy disorder
+		static Parameters createParameters(const int temperature, const bool Enable_gaussian_dos, const double disorder);
+
+		// Checks that all Boltzmann weights and hop rates are finite and positive for the specified site storage mode
+		// at a low temperature with wide Gaussian or exponential disorder, that the hop rate totals match the hop rate
+		// tables, and that the site weight cache returns the same weights as the site storage
+		static bool testWeightRange(const bool Enable_compact_sites, const bool Enable_sparse_sites, const bool Enable_gaussian_dos);
+
+		// Checks that excitons can be created on every site of the lattice without the empty site index, which requires the
+		// linear scan fallback once the lattice is nearly full
+		static bool testCreationFullLattice(const bool Enable_compact_sites, const bool Enable_sparse_sites);
+
+		// Checks that the rates of uphill and downhill hops between two sites whose Boltzmann weights are limited by
+		// Weight_exponent_max match the analytic FRET rates for the specified site storage mode
+		static bool testTailHopRates(const bool Enable_compact_sites);
+
+		// Checks that a simulation that is saved to a checkpoint file and resumed in a new simulation executes exactly the same
+		// events as the original simulation for the specified engine
+		static bool testCheckpointResume(const int engine);
+
+	private:
+		// Prints a failed check and returns false
+		static bool fail(const string& test_name, const string& message);
+	};
+}
+
+int main() {
+	int N_failed = 0;
+	int N_tests = 0;
+	for (int storage_mode = 0; storage_mode < 3; storage_mode++) {
+		for (bool Enable_gaussian_dos : { true, false }) {
+			N_tests++;
+			if (!Exciton_sim_test::testWeightRange(storage_mode == 1, storage_mode == 2, Enable_gaussian_dos)) {
+				N_failed++;
+			}
+		}
+	}
+	for (int storage_mode = 1; storage_mode < 3; storage_mode++) {
+		N_tests++;
+		if (!Exciton_sim_test::testCreationFullLattice(storage_mode == 1, storage_mode == 2)) {
+			N_failed++;
+		}
+	}
+	for (bool Enable_compact_sites : { false, true }) {
+		N_tests++;
+		if (!Exciton_sim_test::testTailHopRates(Enable_compact_sites)) {
+			N_failed++;
+		}
+	}
+	// The engines are the default engine, the first reaction method, the event heap scheduler, the global BKL engine, and
+	// the default engine with the sparse site storage mode
+	for (int engine = 0; engine < 5; engine++) {
+		N_tests++;
+		if (!Exciton_sim_test::testCheckpointResume(engine)) {
+			N_failed++;
+		}
+	}
+	cout << N_tests - N_failed << " of " << N_tests << " tests passed." << endl;
+	return (N_failed == 0) ? 0 : 1;
+}
+
+namespace KMC_Lattice_example {
+
+	Parameters Exciton_sim_test::createParameters(const int temperature, const bool Enable_gaussian_dos, const double disorder) {
+		Parameters params;
+		params.Enable_FRM = false;
+		params.Enable_selective_recalc = true;
+		params.Recalc_cutoff = 3;
+		params.Enable_full_recalc = false;
+		params.Params_lattice.Enable_periodic_x = true;
+		params.Params_lattice.Enable_periodic_y = true;
+		params.Params_lattice.Enable_periodic_z = true;
+		params.Params_lattice.Length = 20;
+		params.Params_lattice.Width = 20;
+		params.Params_lattice.Height = 20;
+		params.Params_lattice.Unit_size = 1.0;
+		params.Temperature = temperature;
+		params.Enable_diffusion_test = true;
+		params.N_tests = 200;
+		params.Exciton_generation_rate = 1e22;
+		params.Exciton_lifetime = 500e-12;
+		params.R_exciton_hopping = 1e12;
+		params.FRET_cutoff = 3;
+		params.Enable_gaussian_dos = Enable_gaussian_dos;
+		params.Site_energy_stdev = disorder;
+		params.Enable_exponential_dos = !Enable_gaussian_dos;
+		params.Site_energy_urbach = disorder;
+		params.Random_seed = 1;
+		return params;
+	}
+
+	bool Exciton_sim_test::fail(const string& test_name, const string& message) {
+		cout << "FAILED " << test_name << ": " << message << endl;
+		return false;
+	}
+
+	// At 10 K, the energies of the sites in the tails of a 0.3 eV wide distribution are several hundred K_b*T away from the
+	// mean, so exp(-E/(K_b*T)) would overflow or underflow even in double precision
+	bool Exciton_sim_test::testWeightRange(const bool Enable_compact_sites, const bool Enable_sparse_sites, const bool Enable_gaussian_dos) {
+		const string test_name = string("weight_range") + (Enable_compact_sites ? "_compact" : "") + (Enable_sparse_sites ? "_sparse" : "") + (Enable_gaussian_dos ? "_gaussian" : "_exponential");
+		Parameters params = createParameters(10, Enable_gaussian_dos, 0.3);
+		params.Enable_compact_sites = Enable_compact_sites;
+		params.Enable_sparse_sites = Enable_sparse_sites;
+		Exciton_sim sim(params, 0);
+		for (long int i = 0; i < sim.lattice.getNumSites(); i++) {
+			const double weight = sim.getSiteWeight(i);
+			if (!std::isfinite(weight) || !(weight > 0.0)) {
+				return fail(test_name, "Boltzmann weight of site " + to_string(i) + " is " + to_string(weight) + ".");
+			}
+		}
+		for (int n = 0; n < 20000 && !sim.checkFinished(); n++) {
+			if (!sim.executeNextEvent()) {
+				return fail(test_name, "Event " + to_string(n) + " could not be executed.");
+			}
+			if (!std::isfinite(sim.getTime())) {
+				return fail(test_name, "Simulation time is not finite after event " + to_string(n) + ".");
+			}
+			for (const auto& exciton_slot : sim.exciton_slots) {
+				if (!exciton_slot.is_active) {
+					continue;
+				}
+				if (!std::isfinite(exciton_slot.hop_rate_total) || exciton_slot.hop_rate_total < 0.0) {
+					return fail(test_name, "Hop rate total is " + to_string(exciton_slot.hop_rate_total) + " after event " + to_string(n) + ".");
+				}
+				// The total kept by the incremental Fenwick tree updates must match the total calculated from the hop rate table
+				double hop_rate_total = 0.0;
+				for (int m = 0; m < (int)sim.hop_prefactors.size(); m++) {
+					hop_rate_total += sim.hop_prefactors[m] * sim.getHopFactor(exciton_slot, m);
+				}
+				if (std::abs(exciton_slot.hop_rate_total - hop_rate_total) > 1e-9 * hop_rate_total) {
+					return fail(test_name, "Hop rate total is " + to_string(exciton_slot.hop_rate_total) + " instead of " + to_string(hop_rate_total) + " after event " + to_string(n) + ".");
+				}
+			}
+		}
+		for (long int i = 0; i < sim.lattice.getNumSites(); i++) {
+			if (sim.getSiteWeightCached(i) != sim.getSiteWeight(i)) {
+				return fail(test_name, "Cached Boltzmann weight of site " + to_string(i) + " does not match the site weight.");
+			}
+		}
+		return true;
+	}
+
+	bool Exciton_sim_test::testCreationFullLattice(const bool Enable_compact_sites, const bool Enable_sparse_sites) {
+		const string test_name = string("creation_full_lattice") + (Enable_compact_sites ? "_compact" : "") + (Enable_sparse_sites ? "_sparse" : "");
+		Parameters params = createParameters(300, true, 0.05);
+		params.Params_lattice.Length = 8;
+		params.Params_lattice.Width = 8;
+		params.Params_lattice.Height = 8;
+		params.Enable_compact_sites = Enable_compact_sites;
+		params.Enable_sparse_sites = Enable_sparse_sites;
+		Exciton_sim sim(params, 0);
+		while (sim.N_excitons < sim.lattice.getNumSites()) {
+			Coords coords = sim.calculateExcitonCreationCoords();
+			if (coords.x < 0 || sim.isSiteOccupied(coords)) {
+				return fail(test_name, "No empty site was found for exciton " + to_string(sim.N_excitons + 1) + ".");
+			}
+			sim.executeExcitonCreation(&sim.exciton_creation_event);
+		}
+		for (long int i = 0; i < sim.lattice.getNumSites(); i++) {
+			if (!sim.isSiteOccupied(i)) {
+				return fail(test_name, "Site " + to_string(i) + " is empty after filling the lattice.");
+			}
+		}
+		return true;
+	}
+
+	// At 10 K, the weights of sites more than 350*K_b*T = 0.30 eV from the mean energy are limited, so the two sites are placed
+	// 1.0 eV and 0.99 eV below the mean, where the weight ratio would give a Boltzmann factor of one for both hop directions
+	bool Exciton_sim_test::testTailHopRates(const bool Enable_compact_sites) {
+		const string test_name = string("tail_hop_rates") + (Enable_compact_sites ? "_compact" : "");
+		Parameters params = createParameters(10, true, 0.05);
+		params.Enable_compact_sites = Enable_compact_sites;
+		Exciton_sim sim(params, 0);
+		const Coords coords1(5, 5, 5);
+		const Coords coords2(6, 5, 5);
+		const long int site_index1 = sim.lattice.getSiteIndex(coords1);
+		const long int site_index2 = sim.lattice.getSiteIndex(coords2);
+		sim.setSiteEnergy(site_index1, -1.0);
+		sim.setSiteEnergy(site_index2, -0.99);
+		sim.calculateBoltzmannWeights();
+		const double energy_delta = sim.getSiteEnergy(site_index2) - sim.getSiteEnergy(site_index1);
+		if (sim.getSiteWeight(site_index1) != sim.getSiteWeight(site_index2)) {
+			return fail(test_name, "The Boltzmann weights of the two sites are not both limited.");
+		}
+		int n_forward = -1, n_backward = -1;
+		for (int n = 0; n < (int)sim.hop_stencil.size(); n++) {
+			const auto& offset = sim.hop_stencil[n];
+			if (offset.dy == 0 && offset.dz == 0 && offset.dx == 1) {
+				n_forward = n;
+			}
+			if (offset.dy == 0 && offset.dz == 0 && offset.dx == -1) {
+				n_backward = n;
+			}
+		}
+		auto& exciton_slot = sim.exciton_slots[sim.allocateExcitonSlot()];
+		// The uphill hop from site 1 to site 2
+		exciton_slot.exciton.setCoords(coords1);
+		sim.calculateHopRateTable(exciton_slot);
+		const double prefactor = sim.hop_stencil[n_forward].prefactor;
+		const double rate_uphill_expected = prefactor * exp(-energy_delta / (K_b * params.Temperature));
+		const double rate_uphill = exciton_slot.hop_rates.getRate(n_forward);
+		if (!(std::abs(rate_uphill - rate_uphill_expected) <= 1e-12 * rate_uphill_expected)) {
+			return fail(test_name, "Uphill hop rate is " + to_string(rate_uphill) + " instead of " + to_string(rate_uphill_expected) + ".");
+		}
+		// The downhill hop from site 2 to site 1
+		exciton_slot.exciton.setCoords(coords2);
+		sim.calculateHopRateTable(exciton_slot);
+		const double rate_downhill = exciton_slot.hop_rates.getRate(n_backward);
+		if (rate_downhill != sim.hop_stencil[n_backward].prefactor) {
+			return fail(test_name, "Downhill hop rate is " + to_string(rate_downhill) + " instead of " + to_string(sim.hop_stencil[n_backward].prefactor) + ".");
+		}
+		return true;
+	}
+
+	bool Exciton_sim_test::testCheckpointResume(const int engine) {
+		const string engine_names[] = { "default", "frm", "event_heap", "global_bkl", "sparse" };
+		const string test_name = "checkpoint_resume_" + engine_names[engine];
+		const string filename = "test_checkpoint.bin";
+		const int N_events_saved = 10000;
+		const int N_events_resumed = 10000;
+		Parameters params = createParameters(300, true, 0.05);
+		// The generation rate is high enough and the hopping rate low enough that tens of excitons are present at once and many
+		// slots are reused within the simulated events
+		params.Exciton_generation_rate = 1e28;
+		params.R_exciton_hopping = 1e10;
+		params.N_tests = 100000;
+		params.Enable_FRM = (engine == 1);
+		params.Enable_selective_recalc = (engine != 1);
+		params.Enable_event_heap = (engine == 2);
+		params.Enable_global_bkl = (engine == 3);
+		params.Enable_sparse_sites = (engine == 4);
+		Exciton_sim sim(params, 0);
+		for (int n = 0; n < N_events_saved; n++) {
+			if (!sim.executeNextEvent()) {
+				return fail(test_name, "Event " + to_string(n) + " could not be executed.");
+			}
+		}
+		if (!sim.saveCheckpoint(filename)) {
+			return fail(test_name, "The checkpoint file could not be saved.");
+		}
+		Exciton_sim sim_resumed(params, 0);
+		const bool is_loaded = sim_resumed.loadCheckpoint(filename);
+		remove(filename.c_str());
+		if (!is_loaded) {
+			return fail(test_name, "The checkpoint file could not be loaded.");
+		}
+		for (int n = 0; n < N_events_resumed; n++) {
+			if (!sim.executeNextEvent() || !sim_resumed.executeNextEvent()) {
+				return fail(test_name, "Event " + to_string(N_events_saved + n) + " could not be executed.");
+			}
+		}
+		if (sim_resumed.getTime() != sim.getTime() || sim_resumed.getN_events_executed() != sim.getN_events_executed() || sim_resumed.N_excitons_created != sim.N_excitons_created || sim_resumed.N_excitons_recombined != sim.N_excitons_recombined) {
+			return fail(test_name, "The time or counters of the resumed simulation do not match after " + to_string(N_events_resumed) + " events.");
+		}
+		if (sim.N_excitons_recombined < 100 || sim_resumed.diffusion_stats.getMean() != sim.diffusion_stats.getMean() || sim_resumed.diffusion_stats.getM2() != sim.diffusion_stats.getM2()) {
+			return fail(test_name, "The diffusion statistics of the resumed simulation do not match.");
+		}
+		if (sim_resumed.exciton_slots.size() != sim.exciton_slots.size()) {
+			return fail(test_name, "The resumed simulation has " + to_string(sim_resumed.exciton_slots.size()) + " exciton slots instead of " + to_string(sim.exciton_slots.size()) + ".");
+		}
+		for (int i = 0; i < (int)sim.exciton_slots.size(); i++) {
+			const auto& slot = sim.exciton_slots[i];
+			const auto& slot_resumed = sim_resumed.exciton_slots[i];
+			if (slot_resumed.is_active != slot.is_active || (slot.is_active && (slot_resumed.exciton.getTag() != slot.exciton.getTag() || !(slot_resumed.exciton.getCoords() == slot.exciton.getCoords()) || slot_resumed.hop_rate_total != slot.hop_rate_total))) {
+				return fail(test_name, "Exciton slot " + to_string(i) + " of the resumed simulation does not match.");
+			}
+		}
+		return true;
+	}
+
+}